@@ -0,0 +1,153 @@
+#ifndef ARENA_TREAP_H
+#define ARENA_TREAP_H
+
+#include <cstdint>
+#include <iostream>
+
+#include "mmap_arena.h"
+#include "rand_int_generator.h"
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   FILE-BACKED RANDOMISED TREAP
+ *
+ *   Same algorithm as RandomisedTreap, but nodes live in an MmapArena and link to each other by
+ *   slot index, so the tree can be larger than RAM and survives being reopened.
+ * ******************************************************************************************** */
+
+struct arena_node {
+    element elem;
+    int priority;
+    uint32_t left;
+    uint32_t right;
+};
+
+class ArenaTreap {
+   private:
+    MmapArena arena;
+
+    arena_node* at(const uint32_t n) { return (arena_node*)arena.at(n); }
+
+    uint32_t rotate_left(const uint32_t head) {
+        const uint32_t temp = at(head)->right;
+        at(head)->right = at(temp)->left;
+        at(temp)->left = head;
+        return temp;
+    }
+
+    uint32_t rotate_right(const uint32_t head) {
+        const uint32_t temp = at(head)->left;
+        at(head)->left = at(temp)->right;
+        at(temp)->right = head;
+        return temp;
+    }
+
+    // Core helper function for insertion operation.
+    // `n` must already be allocated: allocating during the descent could remap the arena.
+    uint32_t insert_node(const uint32_t head, const uint32_t n) {
+        if (head == ARENA_NULL) {
+            return n;
+        }
+        arena_node* h = at(head);
+        if (at(n)->elem.KEY <= h->elem.KEY) {
+            h->left = insert_node(h->left, n);
+            if (at(h->left)->priority < h->priority) {
+                return rotate_right(head);
+            }
+        } else {
+            h->right = insert_node(h->right, n);
+            if (at(h->right)->priority < h->priority) {
+                return rotate_left(head);
+            }
+        }
+        return head;
+    }
+
+    // Core helper function for deletion operation: rotates the target down until it is a leaf
+    uint32_t delete_node(const uint32_t head, const int key) {
+        if (head == ARENA_NULL) {
+            return ARENA_NULL;
+        }
+        arena_node* h = at(head);
+        if (key < h->elem.KEY) {
+            h->left = delete_node(h->left, key);
+            return head;
+        }
+        if (h->elem.KEY < key) {
+            h->right = delete_node(h->right, key);
+            return head;
+        }
+
+        // Found target
+        if (h->left == ARENA_NULL && h->right == ARENA_NULL) {  // is leaf => delete
+            arena.free(head);
+            return ARENA_NULL;
+        }
+        uint32_t new_head;
+        if (h->right == ARENA_NULL ||
+            (h->left != ARENA_NULL && at(h->left)->priority < at(h->right)->priority)) {
+            new_head = rotate_right(head);
+            at(new_head)->right = delete_node(head, key);
+        } else {
+            new_head = rotate_left(head);
+            at(new_head)->left = delete_node(head, key);
+        }
+        return new_head;
+    }
+
+    // Core helper function for height
+    int get_height(const uint32_t node, const int depth) {
+        if (node == ARENA_NULL) {
+            return depth;
+        }
+        return max(get_height(at(node)->left, depth + 1), get_height(at(node)->right, depth + 1));
+    }
+
+   public:
+    ArenaTreap() {}
+
+    // Open (or create) the backing file. Reopening an existing file resumes the stored treap.
+    bool open(const char* path) { return arena.open(path, sizeof(arena_node)); }
+
+    void close() { arena.close(); }
+
+    // Perform insertion operation
+    void insert(element e) {
+        const uint32_t n = arena.alloc();
+        arena_node* node = at(n);
+        node->elem = e;
+        node->priority = rng.rand_priority();
+        node->left = ARENA_NULL;
+        node->right = ARENA_NULL;
+        arena.set_root(insert_node((uint32_t)arena.get_root(), n));
+    }
+
+    // Perform deletion operation
+    void delet(const int key) { arena.set_root(delete_node((uint32_t)arena.get_root(), key)); }
+
+    // Perform search operation
+    element* search(const int key) {
+        uint32_t n = (uint32_t)arena.get_root();
+        while (n != ARENA_NULL) {
+            arena_node* node = at(n);
+            if (node->elem.KEY == key) {
+                return &node->elem;
+            }
+            n = (key < node->elem.KEY) ? node->left : node->right;
+        }
+        return NULL;
+    }
+
+    int get_height() { return get_height((uint32_t)arena.get_root(), 0); }
+
+    uint64_t size() const { return arena.live_slots(); }
+
+    size_t file_bytes() const { return arena.file_bytes(); }
+
+    bool checkpoint() { return arena.checkpoint(); }
+
+    void advise(const int advice) { arena.advise(advice); }
+};
+
+#endif  // ARENA_TREAP_H
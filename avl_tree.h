@@ -0,0 +1,204 @@
+#ifndef AVL_TREE_H
+#define AVL_TREE_H
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+#include "rand_int_generator.h"
+#include "treap_ops.h"
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   AVL TREE
+ *
+ *   Deterministic balanced BST, as a reference engine for RandomisedTreap: every node stores
+ *   the height of its subtree, and the two subtrees of a node differ in height by at most one,
+ *   restored by single or double rotations on the way back up from an insertion or deletion.
+ *   Duplicate keys are allowed and go left, as in the treap.
+ * ******************************************************************************************** */
+
+struct avl_node {
+    element elem;
+    int height;  // of the subtree rooted here; a leaf has height 1
+    avl_node* left;
+    avl_node* right;
+
+    avl_node(element e) : elem(e), height(1), left(NULL), right(NULL) {}
+
+    int get_key() { return elem.KEY; }
+};
+
+class AvlTree {
+   private:
+    avl_node* head;
+    size_t num_nodes;
+
+    static int height_of(const avl_node* node) { return node != NULL ? node->height : 0; }
+
+    static void update(avl_node* node) {
+        node->height = 1 + max(height_of(node->left), height_of(node->right));
+    }
+
+    avl_node* rotate_left(avl_node* head) {
+        avl_node* temp = head->right;
+        head->right = temp->left;
+        temp->left = head;
+        update(head);
+        update(temp);
+        return temp;
+    }
+
+    avl_node* rotate_right(avl_node* head) {
+        avl_node* temp = head->left;
+        head->left = temp->right;
+        temp->right = head;
+        update(head);
+        update(temp);
+        return temp;
+    }
+
+    // Restore the height difference of at most one at head. Returns the new subtree root.
+    avl_node* rebalance(avl_node* head) {
+        update(head);
+        const int balance = height_of(head->left) - height_of(head->right);
+        if (balance > 1) {
+            if (height_of(head->left->left) < height_of(head->left->right)) {
+                head->left = rotate_left(head->left);
+            }
+            return rotate_right(head);
+        }
+        if (balance < -1) {
+            if (height_of(head->right->right) < height_of(head->right->left)) {
+                head->right = rotate_right(head->right);
+            }
+            return rotate_left(head);
+        }
+        return head;
+    }
+
+    // Core helper function for insertion operation
+    avl_node* insert_node(avl_node* head, avl_node* n) {
+        if (head == NULL) {
+            return n;
+        }
+        if (n->get_key() <= head->get_key()) {
+            head->left = insert_node(head->left, n);
+        } else {
+            head->right = insert_node(head->right, n);
+        }
+        return rebalance(head);
+    }
+
+    // Core helper function for deletion operation: unlink the smallest node under head into min
+    avl_node* remove_min(avl_node* head, avl_node*& min) {
+        if (head->left == NULL) {
+            min = head;
+            return head->right;
+        }
+        head->left = remove_min(head->left, min);
+        return rebalance(head);
+    }
+
+    // Core helper function for deletion operation: delete the node search() would find
+    avl_node* delete_key(avl_node* head, const int key) {
+        if (head == NULL) {
+            return NULL;
+        }
+        if (key < head->get_key()) {
+            head->left = delete_key(head->left, key);
+        } else if (key > head->get_key()) {
+            head->right = delete_key(head->right, key);
+        } else {
+            avl_node* left = head->left;
+            avl_node* right = head->right;
+            delete (head);
+            num_nodes--;
+            if (right == NULL) {
+                return left;
+            }
+            avl_node* successor = NULL;
+            right = remove_min(right, successor);
+            successor->left = left;
+            successor->right = right;
+            return rebalance(successor);
+        }
+        return rebalance(head);
+    }
+
+    // Core helper function for range scans. Equal keys can sit on either side of a node after
+    // rotations, so both bounds are inclusive.
+    int range_node(avl_node* head, const int lo, const int hi) {
+        if (head == NULL) {
+            return 0;
+        }
+        const int key = head->get_key();
+        int count = (lo <= key && key <= hi);
+        if (lo <= key) {
+            count += range_node(head->left, lo, hi);
+        }
+        if (key <= hi) {
+            count += range_node(head->right, lo, hi);
+        }
+        return count;
+    }
+
+    // Core helper function for validate: BST order within [lo, hi], heights and balance
+    bool valid_node(avl_node* node, const int lo, const int hi, size_t& count) {
+        if (node == NULL) {
+            return true;
+        }
+        count++;
+        const int hl = height_of(node->left);
+        const int hr = height_of(node->right);
+        const bool ok = lo <= node->get_key() && node->get_key() <= hi &&
+                        node->height == 1 + max(hl, hr) && abs(hl - hr) <= 1;
+        return ok && valid_node(node->left, lo, node->get_key(), count) &&
+               valid_node(node->right, node->get_key(), hi, count);
+    }
+
+   public:
+    AvlTree() : head(NULL), num_nodes(0) {}
+    ~AvlTree() { treap_dealloc(head); }
+
+    AvlTree(const AvlTree&) = delete;
+    AvlTree& operator=(const AvlTree&) = delete;
+
+    // Perform insertion operation
+    void insert(element e) {
+        num_nodes++;
+        head = insert_node(head, new avl_node(e));
+    }
+
+    // Perform deletion operation
+    void delet(const int key) { head = delete_key(head, key); }
+
+    // Perform search operation
+    element* search(const int key) {
+        avl_node* node = head;
+        while (node != NULL && node->get_key() != key) {
+            node = key < node->get_key() ? node->left : node->right;
+        }
+        return node != NULL ? &node->elem : NULL;
+    }
+
+    // Perform range scan: number of elements with lo <= key <= hi
+    int range_scan(const int lo, const int hi) { return range_node(head, lo, hi); }
+
+    size_t size() { return num_nodes; }
+
+    int get_height() { return height_of(head); }
+
+    size_t bytes_allocated() { return num_nodes * sizeof(avl_node); }
+
+    size_t bytes_live() { return num_nodes * sizeof(element); }
+
+    // BST order, stored heights, balance and the node count
+    bool validate() {
+        size_t count = 0;
+        return valid_node(head, INT_MIN, INT_MAX, count) && count == num_nodes;
+    }
+};
+
+#endif  // AVL_TREE_H
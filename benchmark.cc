@@ -0,0 +1,687 @@
+#include "benchmark.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   STATISTICS
+ * ******************************************************************************************** */
+
+// Two-sided 95% critical values of Student's t for 1..30 degrees of freedom
+static const double T95[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+                             2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+                             2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+                             2.060,  2.056, 2.052, 2.048, 2.045, 2.042};
+
+bench_summary summarise(vector<double> samples) {
+    bench_summary s = {0, 0, 0, 0, 0};
+    const size_t n = samples.size();
+    if (n == 0) {
+        return s;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        s.mean += samples[i];
+    }
+    s.mean /= n;
+
+    sort(samples.begin(), samples.end());
+    s.median = (n % 2 == 1) ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2;
+
+    if (n > 1) {
+        double sum_sq = 0;
+        for (size_t i = 0; i < n; i++) {
+            sum_sq += (samples[i] - s.mean) * (samples[i] - s.mean);
+        }
+        s.stddev = sqrt(sum_sq / (n - 1));  // sample standard deviation
+    }
+
+    const double t = (n - 1 >= 1 && n - 1 <= 30) ? T95[n - 2] : 1.96;
+    const double half_width = (n > 1) ? t * s.stddev / sqrt((double)n) : 0;
+    s.ci95_low = s.mean - half_width;
+    s.ci95_high = s.mean + half_width;
+    return s;
+}
+
+/* ******************************************************************************************** *
+ *   CONFIGURATION PARSING
+ * ******************************************************************************************** */
+
+static vector<string> split(const string& s, const char sep) {
+    vector<string> parts;
+    stringstream ss(s);
+    string part;
+    while (getline(ss, part, sep)) {
+        if (!part.empty()) {
+            parts.push_back(part);
+        }
+    }
+    return parts;
+}
+
+static bool is_known_engine(const string& engine) {
+    bool known = false;
+    for_each_engine([&](auto, const engine_info& info) { known = known || engine == info.name; });
+    return known;
+}
+
+static bool load_config_file(const string& path, bench_config& config);
+
+// Apply a single key=value setting. Returns false (after printing why) if it is invalid.
+static bool apply_option(const string& key, const string& value, bench_config& config) {
+    if (key == "config") {
+        return load_config_file(value, config);
+    } else if (key == "engines") {
+        config.engines = split(value, ',');
+        for (size_t i = 0; i < config.engines.size(); i++) {
+            if (!is_known_engine(config.engines[i])) {
+                cerr << "Unknown engine: " << config.engines[i] << '\n';
+                return false;
+            }
+        }
+    } else if (key == "sizes") {
+        config.sizes.clear();
+        vector<string> sizes = split(value, ',');
+        for (size_t i = 0; i < sizes.size(); i++) {
+            config.sizes.push_back(atoi(sizes[i].c_str()));
+            if (config.sizes.back() < BENCH_MIN_OPERATIONS) {
+                cerr << "Sizes must be at least " << BENCH_MIN_OPERATIONS << '\n';
+                return false;
+            }
+        }
+    } else if (key == "mixes") {  // e.g. 90:5:5,50:25:25,0:0:50:0:50
+        config.mixes.clear();
+        vector<string> mixes = split(value, ',');
+        for (size_t i = 0; i < mixes.size(); i++) {
+            vector<string> pcts = split(mixes[i], ':');
+            if (pcts.size() < 3 || pcts.size() > 5) {
+                cerr << "Mixes must be insert:delete:search[:range[:update]] percentages\n";
+                return false;
+            }
+            int p[5] = {0, 0, 0, 0, 0};
+            for (size_t j = 0; j < pcts.size(); j++) {
+                p[j] = atoi(pcts[j].c_str());
+            }
+            bench_mix mix = {p[0], p[1], p[2], p[3], p[4]};
+            if (mix.insert_pct < 0 || mix.delete_pct < 0 || mix.search_pct < 0 ||
+                mix.range_pct < 0 || mix.update_pct < 0 ||
+                mix.insert_pct + mix.delete_pct + mix.search_pct + mix.range_pct +
+                        mix.update_pct != 100) {
+                cerr << "Mix percentages must be non-negative and sum to 100\n";
+                return false;
+            }
+            config.mixes.push_back(mix);
+        }
+    } else if (key == "workload") {
+        if (value != "experiment" && !key_dist_from_name(value, config.spec.key_dist)) {
+            cerr << "Workload must be experiment, uniform, zipf, sequential, clustered or "
+                    "hotspot\n";
+            return false;
+        }
+        config.workload = value;
+    } else if (key == "ycsb") {  // preset mix; defaults to a zipf workload as in YCSB
+        workload_mix w;
+        if (value.size() != 1 || !ycsb_mix(value[0], w)) {
+            cerr << "YCSB preset must be a, b, c or e\n";
+            return false;
+        }
+        bench_mix mix = {w.insert_pct, w.delete_pct, w.search_pct, w.range_pct, w.update_pct};
+        config.mixes = {mix};
+        if (config.workload == "experiment") {
+            config.workload = "zipf";
+            config.spec.key_dist = KEYDIST_ZIPF;
+        }
+    } else if (key == "theta") {
+        config.spec.zipf_theta = atof(value.c_str());
+        if (config.spec.zipf_theta <= 0 || config.spec.zipf_theta == 1) {
+            cerr << "Theta must be positive and not 1\n";
+            return false;
+        }
+    } else if (key == "seed") {
+        config.seed = strtoull(value.c_str(), NULL, 10);
+    } else if (key == "gen-threads") {
+        config.gen_threads = atoi(value.c_str());
+    } else if (key == "preload") {
+        config.preload = atoi(value.c_str());
+    } else if (key == "scan-span") {
+        config.spec.max_scan_span = atoi(value.c_str());
+        if (config.spec.max_scan_span < 1) {
+            cerr << "Scan span must be at least 1\n";
+            return false;
+        }
+    } else if (key == "warmup") {
+        config.warmup = atoi(value.c_str());
+    } else if (key == "trials") {
+        config.trials = atoi(value.c_str());
+        if (config.trials < 1) {
+            cerr << "Need at least one trial\n";
+            return false;
+        }
+    } else if (key == "timer") {
+        if (value == "steady") {
+            config.timer = BENCH_TIMER_STEADY;
+        } else if (value == "tsc") {
+            config.timer = BENCH_TIMER_TSC;
+        } else {
+            cerr << "Timer must be steady or tsc\n";
+            return false;
+        }
+    } else if (key == "format") {
+        if (value != "text" && value != "csv" && value != "json") {
+            cerr << "Format must be text, csv or json\n";
+            return false;
+        }
+        config.format = value;
+    } else if (key == "out") {
+        config.out_path = value;
+    } else if (key == "baseline") {
+        config.baseline_path = value;
+    } else if (key == "threshold") {
+        config.threshold_pct = atof(value.c_str());
+    } else {
+        cerr << "Unknown option: " << key << '\n';
+        return false;
+    }
+    return true;
+}
+
+// Config files hold one key=value setting per line; '#' starts a comment
+static bool load_config_file(const string& path, bench_config& config) {
+    ifstream in(path.c_str());
+    if (!in) {
+        cerr << "Failed to open config " << path << '\n';
+        return false;
+    }
+    string line;
+    while (getline(in, line)) {
+        line = line.substr(0, line.find('#'));
+        line.erase(remove_if(line.begin(), line.end(), ::isspace), line.end());
+        if (line.empty()) {
+            continue;
+        }
+        const size_t eq = line.find('=');
+        if (eq == string::npos || !apply_option(line.substr(0, eq), line.substr(eq + 1), config)) {
+            cerr << "Invalid config line: " << line << '\n';
+            return false;
+        }
+    }
+    return true;
+}
+
+// Options are --key=value, applied left to right, so later options override a --config file
+bool parse_bench_args(int argc, char** argv, bench_config& config) {
+    for (int i = 0; i < argc; i++) {
+        const string arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == string::npos) {
+            cerr << "Expected --key=value, got " << arg << '\n';
+            return false;
+        }
+        if (!apply_option(arg.substr(2, eq - 2), arg.substr(eq + 1), config)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* ******************************************************************************************** *
+ *   TRIALS
+ * ******************************************************************************************** */
+
+static volatile int bench_sink;  // keeps search results observable
+
+// Search cache counters: only the treaps have a cache. The treap variants derive from
+// RandomisedTreap, so the overload is picked with is_base_of rather than by conversion, which
+// would lose to the template.
+template <class Engine>
+static void add_cache_stats(Engine&, bench_result&, false_type) {}
+
+static void add_cache_stats(RandomisedTreap& ds, bench_result& r, true_type) {
+    const hot_cache_stats cs = ds.get_cache_stats();
+    r.cache_hits += cs.hits;
+    r.cache_misses += cs.misses;
+}
+
+template <class Engine>
+static void add_cache_stats(Engine& ds, bench_result& r) {
+    add_cache_stats(ds, r, is_base_of<RandomisedTreap, Engine>());
+}
+
+// Time one trial on a fresh DataStructure, after applying the untimed `load` operations.
+// Deferred work (the insert buffer, tombstones) is settled after the load, outside the timer,
+// and again before the timer stops, so the timed ops pay for exactly their own.
+// Latencies and the final footprint go into `r`.
+template <class DataStructure>
+double time_trial(const vector<packed_op>& load, const vector<packed_op>& ops, const int timer,
+                  PerfCounters& perf, bench_result& r) {
+    DataStructure ds;
+    int hits = 0;
+    for (size_t i = 0; i < load.size(); i++) {
+        ds.insert(load[i].ELEM);
+    }
+    settle_engine(ds);
+
+    const uint64_t start = (timer == BENCH_TIMER_TSC) ? read_tsc() : steady_now_ns();
+    perf.start();
+    for (size_t i = 0; i < ops.size(); i++) {
+        LATENCY_BEGIN(i);
+        hits += apply_op(ds, ops[i]);
+        LATENCY_END(r.latency.by_type[ops[i].TYPE]);
+    }
+    settle_engine(ds);
+    perf.stop();
+    const uint64_t end = (timer == BENCH_TIMER_TSC) ? read_tsc() : steady_now_ns();
+
+    if (!structure_valid(ds)) {
+        cerr << r.engine << " failed validation after a trial, aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+    add_cache_stats(ds, r);
+    r.final_size = ds.size();
+    r.bytes_allocated = ds.bytes_allocated();
+    r.bytes_live = ds.bytes_live();
+    bench_sink = hits;
+    if (timer == BENCH_TIMER_TSC) {
+        return (end - start) / tsc_ticks_per_ns() / 1e9;
+    }
+    return (end - start) / 1e9;
+}
+
+// Time one trial on the engine registered under r.engine
+static double run_trial(const vector<packed_op>& load, const vector<packed_op>& ops,
+                        const int timer, PerfCounters& perf, bench_result& r) {
+    double seconds = -1;
+    for_each_engine([&](auto tag, const engine_info& info) {
+        typedef typename decltype(tag)::type Engine;
+        if (r.engine == info.name) {
+            seconds = time_trial<Engine>(load, ops, timer, perf, r);
+        }
+    });
+    if (seconds < 0) {
+        cerr << "Unknown engine " << r.engine << ", aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+    return seconds;
+}
+
+/* ******************************************************************************************** *
+ *   OUTPUT AND BASELINE COMPARISON
+ * ******************************************************************************************** */
+
+static string case_key(const bench_result& r) {
+    stringstream ss;
+    ss << r.engine << ',' << r.workload << ',' << r.num_operations << ',' << r.mix.insert_pct
+       << ',' << r.mix.delete_pct << ',' << r.mix.search_pct << ',' << r.mix.range_pct << ','
+       << r.mix.update_pct;
+    return ss.str();
+}
+
+// e.g. 90/5/5, or 0/0/50/0/50 when the mix has range scans or updates
+static string mix_label(const bench_mix& mix) {
+    stringstream ss;
+    ss << mix.insert_pct << '/' << mix.delete_pct << '/' << mix.search_pct;
+    if (mix.range_pct > 0 || mix.update_pct > 0) {
+        ss << '/' << mix.range_pct << '/' << mix.update_pct;
+    }
+    return ss.str();
+}
+
+// Columns of case_key(), in order
+static const char* CASE_KEY_COLUMNS[] = {"engine",     "workload",  "num_operations",
+                                         "insert_pct", "delete_pct", "search_pct",
+                                         "range_pct",  "update_pct"};
+#define CASE_KEY_NUM_COLUMNS 8
+
+#ifdef LATENCY_HISTOGRAMS
+static const char* OPTYPE_NAMES[] = {"", "insert", "delete", "search", "range"};
+static const double LATENCY_PERCENTILES[] = {50, 99, 99.9};
+static const char* LATENCY_LABELS[] = {"p50", "p99", "p99.9"};
+
+// Latency columns/fields/lines for one result, converted from TSC ticks to nanoseconds
+static void write_latency(ostream& out, const bench_result& r, const string& format) {
+    const double ticks_per_ns = tsc_ticks_per_ns();
+    for (int type = OPTYPE_INSERTION; type <= OPTYPE_MAX; type++) {
+        const LatencyHistogram& h = r.latency.by_type[type];
+        if (format == "csv") {
+            out << ',' << h.count();
+            for (int p = 0; p < 3; p++) {
+                out << ',' << h.percentile(LATENCY_PERCENTILES[p]) / ticks_per_ns;
+            }
+            out << ',' << h.max_recorded() / ticks_per_ns;
+        } else if (format == "json") {
+            out << ", \"" << OPTYPE_NAMES[type] << "_latency_ns\": {\"count\": " << h.count();
+            for (int p = 0; p < 3; p++) {
+                out << ", \"" << LATENCY_LABELS[p]
+                    << "\": " << h.percentile(LATENCY_PERCENTILES[p]) / ticks_per_ns;
+            }
+            out << ", \"max\": " << h.max_recorded() / ticks_per_ns << '}';
+        } else if (h.count() > 0) {
+            out << "    " << OPTYPE_NAMES[type] << " latency (ns): count=" << h.count();
+            for (int p = 0; p < 3; p++) {
+                out << ' ' << LATENCY_LABELS[p] << '='
+                    << h.percentile(LATENCY_PERCENTILES[p]) / ticks_per_ns;
+            }
+            out << " max=" << h.max_recorded() / ticks_per_ns << '\n';
+        }
+    }
+}
+#endif
+
+// Hardware counter columns/fields/line for one result, per operation. Counters that could not be
+// opened are left empty in CSV and omitted elsewhere.
+static void write_perf(ostream& out, const bench_result& r, const string& format) {
+    const double num_ops = (double)r.num_operations * r.samples.size();
+    bool any = false;
+    for (int c = 0; c < PERF_NUM_COUNTERS; c++) {
+        const double per_op = r.perf_totals[c] / num_ops;
+        if (format == "csv") {
+            out << ',';
+            if (r.perf_available[c]) {
+                out << per_op;
+            }
+        } else if (r.perf_available[c]) {
+            if (format == "json") {
+                out << ", \"" << PERF_COUNTER_NAMES[c] << "_per_op\": " << per_op;
+            } else {
+                out << (any ? " " : "    per op:") << ' ' << PERF_COUNTER_NAMES[c] << '=' << per_op;
+            }
+            any = true;
+        }
+    }
+    if (format == "text" && any) {
+        out << '\n';
+    }
+}
+
+// Footprint columns/fields/line for one result
+static void write_footprint(ostream& out, const bench_result& r, const string& format) {
+    const double overhead_per_element =
+        r.final_size > 0 ? (double)(r.bytes_allocated - r.bytes_live) / r.final_size : 0;
+    if (format == "csv") {
+        out << ',' << r.final_size << ',' << r.bytes_allocated << ',' << overhead_per_element << ','
+            << r.peak_rss_kb;
+    } else if (format == "json") {
+        out << ", \"final_size\": " << r.final_size << ", \"bytes_allocated\": " << r.bytes_allocated
+            << ", \"overhead_per_element\": " << overhead_per_element
+            << ", \"peak_rss_kb\": " << r.peak_rss_kb;
+    } else {
+        out << "    memory: elements=" << r.final_size << " allocated=" << r.bytes_allocated
+            << "B overhead_per_element=" << overhead_per_element
+            << "B peak_rss=" << r.peak_rss_kb << "kB\n";
+    }
+}
+
+// Search cache column/field/line for one result: the hit rate, left empty in CSV and omitted
+// elsewhere for engines without a cache
+static void write_cache(ostream& out, const bench_result& r, const string& format) {
+    const uint64_t lookups = r.cache_hits + r.cache_misses;
+    const double hit_rate = lookups > 0 ? (double)r.cache_hits / lookups : 0;
+    if (format == "csv") {
+        out << ',';
+        if (lookups > 0) {
+            out << hit_rate;
+        }
+    } else if (lookups > 0) {
+        if (format == "json") {
+            out << ", \"cache_hit_rate\": " << hit_rate;
+        } else {
+            out << "    search cache: hits=" << r.cache_hits << " misses=" << r.cache_misses
+                << " hit_rate=" << hit_rate << '\n';
+        }
+    }
+}
+
+static void write_results(ostream& out, const vector<bench_result>& results, const string& format) {
+    if (format == "csv") {
+        for (int c = 0; c < CASE_KEY_NUM_COLUMNS; c++) {
+            out << CASE_KEY_COLUMNS[c] << ',';
+        }
+        out << "trials,mean_s,median_s,stddev_s,ci95_low_s,ci95_high_s,ns_per_op,final_size,"
+               "bytes_allocated,overhead_per_element,peak_rss_kb";
+        for (int c = 0; c < PERF_NUM_COUNTERS; c++) {
+            out << ',' << PERF_COUNTER_NAMES[c] << "_per_op";
+        }
+        out << ",cache_hit_rate";
+#ifdef LATENCY_HISTOGRAMS
+        for (int type = OPTYPE_INSERTION; type <= OPTYPE_MAX; type++) {
+            const string name = OPTYPE_NAMES[type];
+            out << ',' << name << "_count," << name << "_p50_ns," << name << "_p99_ns," << name
+                << "_p99.9_ns," << name << "_max_ns";
+        }
+#endif
+        out << '\n';
+    } else if (format == "json") {
+        out << "[\n";
+    }
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const bench_result& r = results[i];
+        const bench_summary& s = r.summary;
+        const double ns_per_op = s.median * 1e9 / r.num_operations;
+        if (format == "csv") {
+            out << case_key(r) << ',' << r.samples.size() << ',' << s.mean << ',' << s.median
+                << ',' << s.stddev << ',' << s.ci95_low << ',' << s.ci95_high << ',' << ns_per_op;
+            write_footprint(out, r, format);
+            write_perf(out, r, format);
+            write_cache(out, r, format);
+#ifdef LATENCY_HISTOGRAMS
+            write_latency(out, r, format);
+#endif
+            out << '\n';
+        } else if (format == "json") {
+            out << "  {\"engine\": \"" << r.engine << "\", \"workload\": \"" << r.workload
+                << "\", \"num_operations\": " << r.num_operations
+                << ", \"insert_pct\": " << r.mix.insert_pct
+                << ", \"delete_pct\": " << r.mix.delete_pct
+                << ", \"search_pct\": " << r.mix.search_pct
+                << ", \"range_pct\": " << r.mix.range_pct
+                << ", \"update_pct\": " << r.mix.update_pct << ", \"trials\": " << r.samples.size()
+                << ", \"mean_s\": " << s.mean << ", \"median_s\": " << s.median
+                << ", \"stddev_s\": " << s.stddev << ", \"ci95_low_s\": " << s.ci95_low
+                << ", \"ci95_high_s\": " << s.ci95_high << ", \"ns_per_op\": " << ns_per_op;
+            write_footprint(out, r, format);
+            write_perf(out, r, format);
+            write_cache(out, r, format);
+#ifdef LATENCY_HISTOGRAMS
+            write_latency(out, r, format);
+#endif
+            out << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+        } else {
+            out << r.engine << ' ' << r.workload << " L=" << r.num_operations
+                << " mix=" << mix_label(r.mix) << ": median=" << s.median
+                << "s mean=" << s.mean << "s stddev=" << s.stddev << "s ci95=[" << s.ci95_low
+                << ", " << s.ci95_high << "] ns/op=" << ns_per_op << '\n';
+            write_footprint(out, r, format);
+            write_perf(out, r, format);
+            write_cache(out, r, format);
+#ifdef LATENCY_HISTOGRAMS
+            write_latency(out, r, format);
+#endif
+        }
+    }
+
+    if (format == "json") {
+        out << "]\n";
+    }
+}
+
+// Compare medians against a CSV written by an earlier run. Returns the number of regressions.
+static int compare_to_baseline(const vector<bench_result>& results, const bench_config& config) {
+    ifstream in(config.baseline_path.c_str());
+    if (!in) {
+        cerr << "Failed to open baseline " << config.baseline_path << '\n';
+        return 0;
+    }
+
+    // Locate the case key and median columns by name, so baselines from runs with different
+    // optional columns still compare
+    string line;
+    getline(in, line);
+    const vector<string> header = split(line, ',');
+    vector<size_t> key_columns;
+    for (int c = 0; c < CASE_KEY_NUM_COLUMNS; c++) {
+        const size_t pos = find(header.begin(), header.end(), CASE_KEY_COLUMNS[c]) - header.begin();
+        if (pos == header.size()) {
+            cerr << "Baseline " << config.baseline_path << " has no " << CASE_KEY_COLUMNS[c]
+                 << " column\n";
+            return 0;
+        }
+        key_columns.push_back(pos);
+    }
+    const size_t median_column = find(header.begin(), header.end(), "median_s") - header.begin();
+    if (median_column == header.size()) {
+        cerr << "Baseline " << config.baseline_path << " has no median_s column\n";
+        return 0;
+    }
+    // split() drops empty fields, but only trailing columns (e.g. unavailable counters) are empty
+    const size_t min_fields = max(median_column, *max_element(key_columns.begin(),
+                                                               key_columns.end())) + 1;
+
+    map<string, double> baseline;  // case key => median seconds
+    while (getline(in, line)) {
+        vector<string> fields = split(line, ',');
+        if (fields.size() < min_fields) {
+            continue;
+        }
+        string key = fields[key_columns[0]];
+        for (size_t c = 1; c < key_columns.size(); c++) {
+            key += ',' + fields[key_columns[c]];
+        }
+        baseline[key] = atof(fields[median_column].c_str());
+    }
+
+    int regressions = 0;
+    cout << "==Comparison against " << config.baseline_path << "==\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const string key = case_key(results[i]);
+        map<string, double>::const_iterator it = baseline.find(key);
+        if (it == baseline.end() || it->second <= 0) {
+            cout << key << ": no baseline\n";
+            continue;
+        }
+        const double delta_pct = (results[i].summary.median - it->second) / it->second * 100;
+        const char* verdict = "ok";
+        if (delta_pct > config.threshold_pct) {
+            verdict = "REGRESSION";
+            regressions++;
+        } else if (delta_pct < -config.threshold_pct) {
+            verdict = "improved";
+        }
+        cout << key << ": baseline=" << it->second << "s current=" << results[i].summary.median
+             << "s delta=" << delta_pct << "% " << verdict << '\n';
+    }
+    return regressions;
+}
+
+/* ******************************************************************************************** *
+ *   DRIVER
+ * ******************************************************************************************** */
+
+// Run every (size, mix, engine) case in the sweep. Each case gets its own generated workload,
+// shared by all its trials, and a fresh data structure per trial. The "experiment" workload is
+// the shuffled uniform sequence used by the experiments, generated in parallel by
+// ParallelOpGenerator (so --seed reproduces it exactly); any other workload comes from
+// WorkloadGenerator. Either way `preload` records are loaded before the timed operations.
+int run_benchmark(int argc, char** argv) {
+    bench_config config;
+    if (!parse_bench_args(argc, argv, config)) {
+        return 1;
+    }
+
+    for (size_t m = 0; m < config.mixes.size(); m++) {
+        if (config.workload == "experiment" &&
+            (config.mixes[m].range_pct > 0 || config.mixes[m].update_pct > 0)) {
+            cerr << "Range scans and updates need a generated --workload, not experiment\n";
+            return 1;
+        }
+    }
+
+    PerfCounters perf;
+    if (!perf.any_available()) {
+        cout << "Perf counters unavailable, reporting timings only\n";
+    }
+
+    vector<bench_result> results;
+    for (size_t s = 0; s < config.sizes.size(); s++) {
+        for (size_t m = 0; m < config.mixes.size(); m++) {
+            const int num_operations = config.sizes[s];
+            const bench_mix mix = config.mixes[m];
+
+            vector<packed_op> load;
+            vector<packed_op> ops;
+            if (config.workload == "experiment") {
+                const int num_insertions = (int)((long)num_operations * mix.insert_pct / 100);
+                const int num_deletions = (int)((long)num_operations * mix.delete_pct / 100);
+                const int num_searches = num_operations - num_insertions - num_deletions;
+
+                const ParallelOpGenerator gen(config.seed != 0 ? config.seed : rng.rand_seed(),
+                                              config.preload, num_insertions, num_deletions,
+                                              num_searches);
+                cout << "Workload seed: " << gen.get_seed() << '\n';
+                load = gen.gen_load(config.gen_threads);
+                ops = gen.gen_operations(config.gen_threads);
+            } else {
+                workload_spec spec = config.spec;
+                spec.mix = {mix.insert_pct, mix.delete_pct, mix.search_pct, mix.range_pct,
+                            mix.update_pct};
+                WorkloadGenerator wg(spec);
+                load = wg.gen_load(config.preload);
+                ops = wg.gen_run(num_operations);
+            }
+
+            for (size_t e = 0; e < config.engines.size(); e++) {
+                bench_result r;
+                r.engine = config.engines[e];
+                r.workload = config.workload;
+                r.num_operations = num_operations;
+                r.mix = mix;
+                cout << "> " << r.engine << ' ' << r.workload << " L=" << num_operations
+                     << " mix=" << mix_label(mix) << '\n';
+
+                reset_peak_rss();
+                for (int t = 0; t < config.warmup; t++) {
+                    run_trial(load, ops, config.timer, perf, r);
+                }
+                for (int type = 0; type <= OPTYPE_MAX; type++) {
+                    r.latency.by_type[type].reset();  // drop warm-up samples
+                }
+                r.cache_hits = 0;
+                r.cache_misses = 0;
+                for (int c = 0; c < PERF_NUM_COUNTERS; c++) {
+                    r.perf_available[c] = perf.available(c);
+                    r.perf_totals[c] = 0;
+                }
+                for (int t = 0; t < config.trials; t++) {
+                    r.samples.push_back(run_trial(load, ops, config.timer, perf, r));
+                    for (int c = 0; c < PERF_NUM_COUNTERS; c++) {
+                        r.perf_totals[c] += perf.value(c);
+                    }
+                }
+                r.summary = summarise(r.samples);
+                r.peak_rss_kb = get_process_memory().peak_rss_kb;
+                results.push_back(r);
+            }
+        }
+    }
+
+    if (config.out_path.empty()) {
+        write_results(cout, results, config.format);
+    } else {
+        ofstream out(config.out_path.c_str());
+        if (!out) {
+            cerr << "Failed to open " << config.out_path << " for writing\n";
+            return 1;
+        }
+        write_results(out, results, config.format);
+    }
+
+    if (!config.baseline_path.empty() && compare_to_baseline(results, config) > 0) {
+        return BENCH_REGRESSION;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <string>
+#include <vector>
+
+#include "engines.h"
+#include "latency_histogram.h"
+#include "mem_stats.h"
+#include "perf_counters.h"
+#include "timing.h"
+#include "workload_generator.h"
+
+#define BENCH_TIMER_STEADY 0
+#define BENCH_TIMER_TSC 1
+
+#define BENCH_MIN_OPERATIONS 20  // rand_update_sequence3 prints the first and last 10 ops
+
+// Exit status of the benchmark when a comparison against a baseline finds a regression
+#define BENCH_REGRESSION 2
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   BENCHMARK CONFIGURATION
+ * ******************************************************************************************** */
+
+// Percentage of each operation type in a workload. Must sum to 100. Range scans and updates
+// (a deletion then a re-insertion of the same key) need a generated workload, not "experiment".
+struct bench_mix {
+    int insert_pct;
+    int delete_pct;
+    int search_pct;
+    int range_pct;
+    int update_pct;
+};
+
+struct bench_config {
+    vector<string> engines = {"treap", "array"};
+    vector<int> sizes = {100000};
+    vector<bench_mix> mixes = {{90, 5, 5, 0, 0}};
+    string workload = "experiment";  // experiment (DataGenerator) or a workload_spec key dist
+    workload_spec spec;              // key distribution settings for generated workloads
+    int preload = 0;                 // records inserted, untimed, before each trial
+    uint64_t seed = 0;               // experiment workload seed; 0 => a random seed per case
+    int gen_threads = 0;             // threads generating the experiment workload; 0 => all cores
+    int warmup = 1;
+    int trials = 5;
+    int timer = BENCH_TIMER_STEADY;
+    string format = "text";  // text, csv or json
+    string out_path;         // empty => stdout
+    string baseline_path;    // CSV written by a previous run; empty => no comparison
+    double threshold_pct = 5.0;
+};
+
+/* ******************************************************************************************** *
+ *   BENCHMARK RESULTS
+ * ******************************************************************************************** */
+
+struct bench_summary {
+    double mean;
+    double median;
+    double stddev;
+    double ci95_low;  // 95% confidence interval of the mean (Student's t)
+    double ci95_high;
+};
+
+struct bench_result {
+    string engine;
+    string workload;
+    int num_operations;
+    bench_mix mix;
+    vector<double> samples;  // seconds per trial, warm-up trials excluded
+    bench_summary summary;
+    op_latencies latency;  // TSC ticks per operation over all timed trials (LATENCY_HISTOGRAMS)
+    size_t final_size;  // elements left in the structure after a trial
+    size_t bytes_allocated;
+    size_t bytes_live;
+    long peak_rss_kb;  // peak RSS of the process while running this case
+    bool perf_available[PERF_NUM_COUNTERS];
+    uint64_t perf_totals[PERF_NUM_COUNTERS];  // summed over all timed trials
+    uint64_t cache_hits = 0;  // treap-cached search cache, summed over all timed trials
+    uint64_t cache_misses = 0;
+};
+
+bench_summary summarise(vector<double> samples);
+bool parse_bench_args(int argc, char** argv, bench_config& config);
+int run_benchmark(int argc, char** argv);
+
+#endif  // BENCHMARK_H
@@ -1,78 +1,289 @@
-#ifndef DATA_GENERATOR_H
-#define DATA_GENERATOR_H
-
-#include "rand_int_generator.h"
-
-#define DELETED -1
-
-/* ******************************************************************************************** *
- *   DATA GENERATION
- * ******************************************************************************************** */
-
-class DataGenerator {
-   private:
-    int id_next = 1;
-    int* key_list;
-
-   public:
-    DataGenerator() {
-        key_list = (int*)malloc(KEY_MAX * sizeof(int));  // NOTE: Might need more than KEY_MAX
-        if (key_list == NULL) { // Check allocation successful
-            cerr << "Failed to allocate, aborting...\n";
-            exit(EXIT_FAILURE);
-        }
-
-        for (int i = 0; i < KEY_MAX; i++) {
-            key_list[i] = DELETED;
-        }
-    }
-    ~DataGenerator() { free(key_list); }
-
-    element gen_element() {
-        int key = rng.rand_key();
-        element elem = {id_next, key};
-        key_list[id_next - 1] = key;
-        id_next++;
-        return elem;
-    }
-
-    insertion_op gen_insertion() {
-        element elem = gen_element();
-        insertion_op ins = {elem};
-
-        return ins;
-    }
-
-    deletion_op gen_deletion() {
-        int del_id = rng.rand_id(id_next - 1);
-        deletion_op del;
-        if (key_list[del_id - 1] != DELETED) {
-            del = {key_list[del_id - 1]};
-        } else {
-            del = {rng.rand_key()};
-        }
-        return del;
-    }
-
-    search_op gen_search() {
-        search_op sch = {rng.rand_key()};
-        return sch;
-    }
-
-    // For experiment 0 only
-    element gen_specific_element(int key) {
-        element elem = {id_next, key};
-        key_list[id_next - 1] = key;
-        id_next++;
-        return elem;
-    }
-    // For experiment 0 only
-    insertion_op gen_specific_insertion(int key) {
-        element elem = gen_specific_element(key);
-        insertion_op ins = {elem};
-
-        return ins;
-    }
-};
-
-#endif
+#ifndef DATA_GENERATOR_H
+#define DATA_GENERATOR_H
+
+#include <thread>
+
+#include "philox.h"
+#include "rand_int_generator.h"
+
+#define LIVE_KEYS_INITIAL_CAPACITY 1024
+
+// Philox stream ids used by ParallelOpGenerator
+#define STREAM_SEQUENCE 1
+#define STREAM_INSERTION_KEY 2
+#define STREAM_DELETION_TARGET 3
+#define STREAM_SEARCH_KEY 4
+
+/* ******************************************************************************************** *
+ *   DATA GENERATION
+ *
+ *   Keys of generated elements that have not been picked for deletion yet are kept in a dense,
+ *   growable array. A deletion picks a random entry and swap-removes it, so choosing a live key
+ *   is O(1) and memory grows with the number of elements actually generated.
+ * ******************************************************************************************** */
+
+class DataGenerator {
+   private:
+    int id_next = 1;
+    int* live_keys;
+    size_t num_live = 0;
+    size_t capacity = LIVE_KEYS_INITIAL_CAPACITY;
+
+    void grow() {
+        capacity *= 2;
+        int* new_keys = (int*)realloc(live_keys, capacity * sizeof(int));
+        if (new_keys == NULL) { // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        live_keys = new_keys;
+    }
+
+    void track_key(const int key) {
+        if (num_live == capacity) {
+            grow();
+        }
+        live_keys[num_live++] = key;
+    }
+
+   public:
+    DataGenerator() {
+        live_keys = (int*)malloc(capacity * sizeof(int));
+        if (live_keys == NULL) { // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~DataGenerator() { free(live_keys); }
+
+    DataGenerator(const DataGenerator&) = delete;
+    DataGenerator& operator=(const DataGenerator&) = delete;
+
+    size_t bytes_allocated() { return capacity * sizeof(int); }
+
+    // Generated elements not yet targeted by a deletion
+    size_t live_count() { return num_live; }
+
+    element gen_element() {
+        int key = rng.rand_key();
+        element elem = {id_next, key};
+        track_key(key);
+        id_next++;
+        return elem;
+    }
+
+    insertion_op gen_insertion() {
+        element elem = gen_element();
+        insertion_op ins = {elem};
+
+        return ins;
+    }
+
+    // Delete a random live key. Only falls back to a (likely missing) random key if every
+    // generated element has already been deleted.
+    deletion_op gen_deletion() {
+        deletion_op del;
+        if (num_live == 0) {
+            del = {rng.rand_key()};
+            return del;
+        }
+        const size_t i = (size_t)rng.rand_id((int)num_live) - 1;
+        del = {live_keys[i]};
+        live_keys[i] = live_keys[--num_live];
+        return del;
+    }
+
+    search_op gen_search() {
+        search_op sch = {rng.rand_key()};
+        return sch;
+    }
+
+    /* Generate a shuffled sequence of operations the same way the experiments do: insertions are
+     * generated first, so that deletions can target them, then interleaved with
+     * rand_update_sequence3. */
+    vector<packed_op> gen_operations(const int num_insertions, const int num_deletions,
+                                     const int num_searches) {
+        const int num_operations = num_insertions + num_deletions + num_searches;
+        vector<packed_op> insertions(num_insertions);
+        for (int i = 0; i < num_insertions; i++) {
+            insertions[i] = {OPTYPE_INSERTION, gen_insertion().ELEM};
+        }
+        vector<packed_op> deletions(num_deletions);
+        for (int i = 0; i < num_deletions; i++) {
+            deletions[i] = {OPTYPE_DELETION, {0, gen_deletion().KEY}};
+        }
+        vector<packed_op> searches(num_searches);
+        for (int i = 0; i < num_searches; i++) {
+            searches[i] = {OPTYPE_SEARCH, {0, gen_search().KEY}};
+        }
+
+        vector<int> updates =
+            rng.rand_update_sequence3(num_operations, OPTYPE_INSERTION, num_insertions,
+                                      OPTYPE_DELETION, num_deletions, OPTYPE_SEARCH, num_searches);
+
+        vector<packed_op> ops(num_operations);
+        int next_insertion = 0;
+        int next_deletion = 0;
+        int next_search = 0;
+        for (int i = 0; i < num_operations; i++) {
+            if (updates[i] == OPTYPE_INSERTION) {
+                ops[i] = insertions[next_insertion++];
+            } else if (updates[i] == OPTYPE_DELETION) {
+                ops[i] = deletions[next_deletion++];
+            } else {  // OPTYPE_SEARCH
+                ops[i] = searches[next_search++];
+            }
+        }
+        return ops;
+    }
+
+    // For experiment 0 only
+    element gen_specific_element(int key) {
+        element elem = {id_next, key};
+        track_key(key);
+        id_next++;
+        return elem;
+    }
+    // For experiment 0 only
+    insertion_op gen_specific_insertion(int key) {
+        element elem = gen_specific_element(key);
+        insertion_op ins = {elem};
+
+        return ins;
+    }
+};
+
+/* ******************************************************************************************** *
+ *   PARALLEL DATA GENERATION
+ *
+ *   Same shape of workload as DataGenerator::gen_operations, but every operation apart from a
+ *   deletion's target is a pure function of (seed, position), so chunks of the sequence are
+ *   generated on all cores and the result is bit-identical for any number of threads:
+ *   - a random permutation of [0, num_operations) fixes the sequence: position p holds insertion
+ *     j, deletion j or search j depending on where permutation(p) falls;
+ *   - preloaded element j is {j + 1, key(j)} and insertion j is the element after the preload,
+ *     {num_preload + j + 1, key(num_preload + j)};
+ *   - deletion j targets the key of a random live element: one preloaded or inserted earlier in
+ *     the sequence and not deleted yet, drawn with counter j from a pool that deletions
+ *     swap-remove from, as in DataGenerator. This depends on everything before it, so targets
+ *     are filled in by one serial pass over the finished sequence (only a random key, likely
+ *     missing, if nothing is live);
+ *   - search j looks for a random key.
+ * ******************************************************************************************** */
+
+class ParallelOpGenerator {
+   private:
+    uint64_t seed;
+    Philox philox;
+    int num_preload;
+    int num_insertions;
+    int num_deletions;
+    int num_searches;
+    FeistelPermutation permutation;
+
+    int insertion_key(const int j) const {
+        return (int)philox.below(j, STREAM_INSERTION_KEY, KEY_MAX + 1);
+    }
+
+    // out[i] = fill(i) for every i, split into contiguous chunks over num_threads threads
+    // (0 => one per core)
+    template <class Fill>
+    static void parallel_fill(vector<packed_op>& out, int num_threads, Fill fill) {
+        const size_t n = out.size();
+        if (num_threads <= 0) {
+            num_threads = max(1, (int)thread::hardware_concurrency());
+        }
+        num_threads = (int)min((size_t)num_threads, max(n / 4096, (size_t)1));
+
+        const size_t chunk = (n + num_threads - 1) / num_threads;
+        vector<thread> threads;
+        for (int t = 1; t < num_threads; t++) {
+            threads.push_back(thread([&out, &fill, t, chunk, n]() {
+                for (size_t i = t * chunk; i < min(n, (t + 1) * chunk); i++) {
+                    out[i] = fill(i);
+                }
+            }));
+        }
+        for (size_t i = 0; i < min(n, chunk); i++) {
+            out[i] = fill(i);
+        }
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+    }
+
+    // Operation at position p of the sequence, except the key of a deletion (see gen_operations)
+    packed_op op_at(const uint64_t p) const {
+        const int i = (int)permutation(p);
+        packed_op op;
+        if (i < num_insertions) {
+            const int j = num_preload + i;
+            op = {OPTYPE_INSERTION, {j + 1, insertion_key(j)}};
+        } else if (i < num_insertions + num_deletions) {
+            op = {OPTYPE_DELETION, {0, 0}};
+        } else {
+            op = {OPTYPE_SEARCH, {0, (int)philox.below(i, STREAM_SEARCH_KEY, KEY_MAX + 1)}};
+        }
+        return op;
+    }
+
+    // Point every deletion in ops at a live key, in sequence order
+    void fill_deletion_targets(vector<packed_op>& ops) const {
+        vector<int> live;
+        live.reserve((size_t)num_preload + num_insertions);
+        for (int j = 0; j < num_preload; j++) {
+            live.push_back(insertion_key(j));
+        }
+        for (size_t p = 0; p < ops.size(); p++) {
+            if (ops[p].TYPE == OPTYPE_INSERTION) {
+                live.push_back(ops[p].ELEM.KEY);
+            } else if (ops[p].TYPE == OPTYPE_DELETION) {
+                const uint64_t i = permutation(p);
+                if (live.empty()) {  // nothing live to delete
+                    ops[p].ELEM.KEY = (int)philox.below(i, STREAM_SEARCH_KEY, KEY_MAX + 1);
+                    continue;
+                }
+                // Remove the target from the pool (swap with last)
+                const uint32_t t = philox.below(i, STREAM_DELETION_TARGET, (uint32_t)live.size());
+                ops[p].ELEM.KEY = live[t];
+                live[t] = live.back();
+                live.pop_back();
+            }
+        }
+    }
+
+   public:
+    ParallelOpGenerator(const uint64_t seed, const int num_preload, const int num_insertions,
+                        const int num_deletions, const int num_searches)
+        : seed(seed),
+          philox(seed),
+          num_preload(num_preload),
+          num_insertions(num_insertions),
+          num_deletions(num_deletions),
+          num_searches(num_searches),
+          permutation((uint64_t)num_insertions + num_deletions + num_searches, philox,
+                      STREAM_SEQUENCE) {}
+
+    uint64_t get_seed() const { return seed; }
+
+    // Elements to insert before the sequence
+    vector<packed_op> gen_load(const int num_threads = 0) const {
+        vector<packed_op> ops(num_preload);
+        parallel_fill(ops, num_threads, [this](const size_t j) {
+            packed_op op = {OPTYPE_INSERTION, {(int)j + 1, insertion_key((int)j)}};
+            return op;
+        });
+        return ops;
+    }
+
+    vector<packed_op> gen_operations(const int num_threads = 0) const {
+        vector<packed_op> ops((size_t)num_insertions + num_deletions + num_searches);
+        parallel_fill(ops, num_threads, [this](const size_t p) { return op_at(p); });
+        if (num_deletions > 0) {
+            fill_deletion_targets(ops);
+        }
+        return ops;
+    }
+};
+
+#endif
@@ -1,484 +1,1401 @@
-#ifndef DATA_STRUCTURES_H
-#define DATA_STRUCTURES_H
-
-#include <algorithm>
-#include <iostream>
-#include <iterator>
-#include <vector>
-
-#include "data_generator.h"
-#include "rand_int_generator.h"
-
-#define NOT_FOUND -1
-
-using namespace std;
-
-/* ******************************************************************************************** *
- *   RANDOMISED TREAP
- * ******************************************************************************************** */
-
-struct treap_node {
-    element elem;
-    int priority;
-    treap_node* left;
-    treap_node* right;
-
-    treap_node(element e, int p) : elem(e), priority(p), left(NULL), right(NULL) {}
-
-    int get_key() { return elem.KEY; }
-
-    int get_id() { return elem.ID; }
-};
-
-class RandomisedTreap {
-   private:
-    treap_node* head;
-
-    // Core helper function for insertion operation
-    treap_node* insert_node(treap_node* head, treap_node* n) {
-        if (head == NULL) {
-            return n;
-        }
-        // perform bst insert
-        if (n->get_key() <= head->get_key()) {  // TODO: Can use id to break ties for '==' case
-            if (head->left == NULL) {           // insert here
-                head->left = n;
-            } else {  // recurse left
-                head->left = insert_node(head->left, n);
-            }
-        } else {
-            if (head->right == NULL) {  // insert here
-                head->right = n;
-            } else {  // recurse left
-                head->right = insert_node(head->right, n);
-            }
-        }
-
-        // TODO: Could move this into the bst insert logic. Might be slightly faster
-        //  if we inserted: fix the heap condition with rotations, then return the new head
-        if (head->left != NULL && head->left->priority < head->priority) {
-            return rotate_right(head);
-        } else if (head->right != NULL && head->right->priority < head->priority) {
-            return rotate_left(head);
-        }
-
-        // no rotations: return the original head
-        return head;
-    }
-
-    // Core helper function for search operation
-    treap_node* search_node(treap_node* head, const int key) {
-        if (head->get_key() == key) {
-            return head;
-        }
-        if (key < head->get_key() && head->left != NULL) {  // go left
-            return search_node(head->left, key);
-        }
-        if (head->get_key() < key && head->right != NULL) {  // go right
-            return search_node(head->right, key);
-        }
-        return NULL;
-    }
-
-    treap_node* rotate_left(treap_node* head) {
-        treap_node* temp = head->right;
-        head->right = temp->left;
-        temp->left = head;
-        return temp;
-    }
-
-    treap_node* rotate_right(treap_node* head) {
-        treap_node* temp = head->left;
-        head->left = temp->right;
-        temp->right = head;
-        return temp;
-    }
-
-    treap_node* search_parent(treap_node* parent, treap_node* node, const int key) {
-        if (parent != NULL && node->get_key() == key) {
-            node->priority = INT_MAX;  // mark for deletion
-            return parent;
-        }
-        if (key < node->get_key() && node->left != NULL) {  // go left
-            return search_parent(node, node->left, key);
-        }
-        if (node->get_key() < key && node->right != NULL) {  // go right
-            return search_parent(node, node->right, key);
-        }
-        return NULL;
-    }
-
-    bool is_leaf_node(treap_node* node) {
-        if (node == NULL) {
-            cout << "Unexpected check of node being a leaf";
-            return false;
-        }
-        if (node->left == NULL && node->right == NULL) return true;
-        return false;
-    }
-
-    bool only_has_left_child(treap_node* node) {
-        if (node->left != NULL && node->right == NULL) {
-            return true;
-        }
-        return false;
-    }
-
-    bool only_has_right_child(treap_node* node) {
-        if (node->left == NULL && node->right != NULL) {
-            return true;
-        }
-        return false;
-    }
-
-    bool left_smaller_than_right(treap_node* node) {
-        // NOTE: Assumes that left and right both exist
-        assert(("ERROR: Expected left and right to both exist",
-                node->left != NULL && node->right != NULL));
-
-        if ((node->left->priority < node->right->priority) ||  // priority
-            (node->left->priority == node->right->priority &&  // tiebreak using key
-             node->left->get_key() < node->right->get_key())) {
-            return true;
-        }
-        return false;
-    }
-
-    // Core helper function for deletion operation
-    void delete_node(treap_node* parent, const int key) {
-        if (parent == NULL) {
-            return;
-        }
-
-        if (key < parent->get_key() ||
-            (key == parent->get_key() && parent->left != NULL &&
-             key == parent->left->get_key())) {  // Target node is left child
-            assert(("ERROR: Expected left child to exist", parent->left != NULL));
-            assert(
-                ("ERROR: Expected left child to be the target", parent->left->get_key() == key));
-
-            if (is_leaf_node(parent->left)) {  // is leaf => delete
-                delete (parent->left);
-                parent->left = NULL;
-                return;
-            }
-            if (only_has_right_child(parent->left)) {
-                parent->left = rotate_left(parent->left);
-            } else if (only_has_left_child(parent->left)) {
-                parent->left = rotate_right(parent->left);
-            } else if (left_smaller_than_right(parent->left)) {
-                parent->left = rotate_right(parent->left);
-            } else {  // right smaller than left
-                parent->left = rotate_left(parent->left);
-            }
-            delete_node(parent->left, key);
-        } else {  // Target node is right child
-            assert(("ERROR: Expected right child to exist", parent->right != NULL));
-            assert(
-                ("ERROR: Expected right child to be the target", parent->right->get_key() == key));
-
-            if (is_leaf_node(parent->right)) {  // is leaf => delete
-                delete (parent->right);
-                parent->right = NULL;
-                return;
-            }
-            if (only_has_right_child(parent->right)) {
-                parent->right = rotate_left(parent->right);
-            } else if (only_has_left_child(parent->right)) {
-                parent->right = rotate_right(parent->right);
-            } else if (left_smaller_than_right(parent->right)) {
-                parent->right = rotate_right(parent->right);
-            } else {  // right smaller than left
-                parent->right = rotate_left(parent->right);
-            }
-            delete_node(parent->right, key);
-        }
-    }
-
-    // Core helper function for height
-    int get_height(treap_node* node, int depth) {
-        if (node == NULL) {
-            return depth;
-        }
-        return max(get_height(node->left, depth + 1), get_height(node->right, depth + 1));
-    }
-
-    // Core helper function for heigh and node depth
-    int get_height_and_depths_e0(treap_node* node, int* total_depths, int depth) {
-        if (node == NULL) {
-            return depth;
-        }
-        total_depths[node->get_key()] += depth;
-        return max(get_height_and_depths_e0(node->left, total_depths, depth + 1),
-                   get_height_and_depths_e0(node->right, total_depths, depth + 1));
-    }
-
-    // Core helper function for node depth
-    int get_all_node_depths(treap_node* node, int curr_id, int curr_depth, int* depth_array) {
-        if (node == NULL) {
-            return curr_id;
-        }
-        depth_array[curr_id] = curr_depth;
-        curr_id = get_all_node_depths(node->left, curr_id + 1, curr_depth + 1, depth_array);
-        curr_id = get_all_node_depths(node->right, curr_id, curr_depth + 1,
-                                      depth_array);  // TODO: Double-check increment of curr_id
-        return curr_id;
-    }
-
-    int find_depth_of_key_node(treap_node* node, const int key, int depth) {
-        if (node == NULL) {
-            return NOT_FOUND;
-        }
-        if (node->get_key() == key) {
-            return depth;
-        }
-        return max(find_depth_of_key_node(node->left, key, depth + 1),
-                   find_depth_of_key_node(node->right, key, depth + 1));
-    }
-
-    void print(treap_node* head, int depth) {
-        for (int i = 0; i < depth; i++) {
-            cout << "_";
-        }
-        if (head == NULL) {
-            cout << "*EMPTY*\n";
-            return;
-        }
-        cout << '(' << head->get_id() << ", " << head->get_key() << ", " << head->priority
-             << ")\n";
-        print(head->left, depth + 1);
-        print(head->right, depth + 1);
-    }
-
-    bool heap_condition_satisfied(const int parent_prio, treap_node* node) {
-        if (node == NULL) {
-            return true;
-        }
-        if (node->priority < parent_prio) {
-            cout << "Failed heap condition: prio=" << node->priority
-                 << " parent_prio=" << parent_prio << '\n';
-
-            return false;
-        }
-        return heap_condition_satisfied(node->priority, node->left) &&
-               heap_condition_satisfied(node->priority, node->right);
-    }
-
-    bool bst_condition_satisfied(treap_node* node) {
-        if (node == NULL) {
-            return true;
-        }
-        if (node->left != NULL && node->get_key() < node->left->get_key()) {
-            return false;
-        }
-        if (node->right != NULL && node->get_key() > node->right->get_key()) {
-            return false;
-        }
-
-        bool satisfied =
-            (bst_condition_satisfied(node->left) && bst_condition_satisfied(node->right));
-
-        if (!satisfied) {
-            cout << "Failed bst condition\n";
-        }
-        return satisfied;
-    }
-
-    // Deallocate all memory
-    void dealloc_head(treap_node* head) {
-        if (head == NULL) return;
-        if (head->left != NULL) {
-            dealloc_head(head->left);
-        }
-        if (head->right != NULL) {
-            dealloc_head(head->right);
-        }
-        delete (head);
-    }
-
-   public:
-    RandomisedTreap() : head(NULL) {}
-    ~RandomisedTreap() { dealloc_head(head); }
-
-    // Perform insertion operation
-    void insert(element e) {
-        treap_node* n = new treap_node(e, rng.rand_priority());
-        head = insert_node(head, n);
-    }
-
-    // Perform deletion operation
-    void delet(const int key) {
-        if (head == NULL) {
-            return;
-        }
-        if (head->get_key() == key) {
-            cout << "Head deletion\n";
-            head->priority = INT_MAX;
-
-            if (is_leaf_node(head)) {  // is leaf => delete
-                delete (head);
-                head = NULL;
-                return;
-            } else if (only_has_right_child(head)) {
-                head = rotate_left(head);
-                delete (head->left);
-                head->left = NULL;
-                return;
-            } else if (only_has_left_child(head)) {
-                head = rotate_right(head);
-                delete (head->right);
-                head->right = NULL;
-                return;
-            } else if (left_smaller_than_right(head)) {
-                head = rotate_right(head);
-                delete_node(head, key);
-                return;
-            } else {  // right smaller than left
-                head = rotate_left(head);
-                delete_node(head, key);
-                return;
-            }
-            return;
-        }
-        treap_node* parent = search_parent(NULL, head, key);
-        if (parent == NULL) {
-            return;
-        }
-        delete_node(parent, key);
-        //  DELETE:
-        // if (!heap_condition_satisfied(INT_MIN, parent)) {
-        //     // print(parent, 0);
-        // }
-    }
-
-    // Perform search operation
-    element* search(const int key) {
-        treap_node* node = search_node(head, key);
-        if (node == NULL) {
-            return NULL;
-        }
-        return &node->elem;
-    }
-
-    int find_depth_of_key(const int key) { return find_depth_of_key_node(head, key, 0); }
-
-    int get_height() { return get_height(head, 0); }
-
-    int get_height_and_depths_e0(int* total_depths) {
-        return get_height_and_depths_e0(head, total_depths, 0);
-    }
-
-    int* get_all_node_depths(const int num_nodes) {
-        if (head == NULL) {
-            return NULL;
-        }
-
-        int* depths = (int*)calloc(num_nodes, sizeof(int));
-        get_all_node_depths(head, 0, 0, depths);
-
-        return depths;
-    }
-
-    bool heap_condition_satisfied() {
-        if (head == NULL) {
-            return true;
-        }
-        return heap_condition_satisfied(INT_MIN, head);
-    }
-
-    bool bst_condition_satisfied() {
-        if (head == NULL) {
-            return true;
-        }
-        return bst_condition_satisfied(head);
-    }
-
-    void print() { print(head, 0); }
-};
-
-/* ******************************************************************************************** *
- *   DYNAMIC ARRAY
- * ******************************************************************************************** */
-
-class DynamicArray {
-   private:
-    int count = 0;
-    int capacity = 1;
-    element* list;
-
-    void grow() {
-        capacity *= 2;
-        resize();
-    }
-
-    void shrink() {
-        capacity /= 2;
-        resize();
-    }
-
-    void resize() {
-        element* new_list = (element*)malloc(capacity * sizeof(element));
-        if (new_list == NULL) { // Check allocation successful
-            cerr << "Failed to allocate, aborting...\n";
-            exit(EXIT_FAILURE);
-        }
-
-        for (int i = 0; i < count; i++) {
-            new_list[i] = list[i];
-        }
-        free(list);
-        list = new_list;
-    }
-
-   public:
-    DynamicArray() {
-        list = (element*)malloc(1 * sizeof(element));
-        if (list == NULL) { // Check allocation successful
-            cerr << "Failed to allocate, aborting...\n";
-            exit(EXIT_FAILURE);
-        }
-    }
-    ~DynamicArray() { free(list); }
-
-    void insert(element x) {
-        if (count + 1 == capacity) {
-            grow();
-        }
-        list[count++] = x;
-    }
-
-    void delet(int key) {
-        // search for key
-        int pos = search(key);
-        if (pos == NOT_FOUND) {
-            return;
-        }
-
-        // swap with last elem, decrease count
-        element temp = list[pos];
-        count -= 1;
-        list[pos] = list[count];
-        list[count] = temp;
-
-        if (count < (capacity / 4)) {
-            shrink();
-        }
-    }
-
-    int search(int key) {
-        for (int i = 0; i < count; i++) {
-            if (list[i].KEY == key) {
-                return i;
-            }
-        }
-        return NOT_FOUND;
-    }
-
-    void print() {
-        for (int i = 0; i < count; i++) {
-            cout << '(' << list[i].ID << ", " << list[i].KEY << ")\n";
-        }
-    }
-};
-
-#endif  // DATA_STRUCTURES_H
+#ifndef DATA_STRUCTURES_H
+#define DATA_STRUCTURES_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/mman.h>
+
+#include <new>
+
+#include "data_generator.h"
+#include "hot_key_cache.h"
+#include "insert_buffer.h"
+#include "rand_int_generator.h"
+#include "snapshot.h"
+#include "treap_ops.h"
+
+#define NOT_FOUND -1
+
+#define TREAP_STATS_MAX_DEPTH 128  // deeper accesses are counted in the last bucket
+
+// Node orders for RandomisedTreap::compact()
+#define COMPACT_DFS 0  // pre-order: a node is followed by its left subtree
+#define COMPACT_VEB 1  // van Emde Boas: recursively split into top and bottom halves of the levels
+
+#define HUGE_PAGE_SIZE (2UL << 20)
+
+#define ADAPTIVE_DEFAULT_ONE_IN 4  // RandomisedTreap::set_adaptive() rate used by default
+
+#define LAZY_DEFAULT_PURGE_RATIO 0.25  // RandomisedTreap::set_lazy_delete() threshold by default
+
+/* Structural counters are compiled in only with -DTREAP_STATS (make STATS=1). Otherwise
+ * TREAP_STAT(...) expands to nothing and the treap carries no stats state. */
+#ifdef TREAP_STATS
+#define TREAP_STAT(stmt) stmt
+#else
+#define TREAP_STAT(stmt)
+#endif
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   RANDOMISED TREAP
+ * ******************************************************************************************** */
+
+// Snapshot of what the treap has done internally since construction (or reset_stats())
+struct treap_stats {
+    uint64_t inserts;
+    uint64_t deletes;  // deletions that found their key
+    uint64_t searches;
+    uint64_t rotations;
+    uint64_t insert_rotations;
+    uint64_t delete_rotations;
+    uint64_t comparisons;    // key comparisons made while descending
+    uint64_t nodes_visited;  // nodes touched while descending
+    uint64_t depth_total;    // sum of depths of accessed nodes
+    uint64_t depth_histogram[TREAP_STATS_MAX_DEPTH];  // depth of each accessed node
+};
+
+// Result of RandomisedTreap::validate(): invariants and shape, from one walk over every node
+struct treap_shape {
+    bool bst_ok;   // every key within the bounds set by its ancestors
+    bool heap_ok;  // no node has a smaller priority than its parent
+    bool size_ok;  // nodes reached == size()
+    size_t nodes;
+    int height;                        // levels; 0 for an empty treap
+    vector<uint64_t> depth_histogram;  // nodes at each depth (root = 0)
+
+    bool ok() const { return bst_ok && heap_ok && size_ok; }
+};
+
+struct treap_node {
+    element elem;
+    int priority;
+    bool deleted;  // lazy-deletion tombstone; sits in padding, so nodes stay 32 bytes
+    treap_node* left;
+    treap_node* right;
+
+    treap_node(element e, int p) : elem(e), priority(p), deleted(false), left(NULL), right(NULL) {}
+
+    int get_key() { return elem.KEY; }
+
+    int get_id() { return elem.ID; }
+};
+
+class RandomisedTreap {
+   private:
+    treap_node* head;
+    size_t num_nodes;
+
+    // Contiguous node storage laid out by compact(). Nodes allocated since come from `new`,
+    // except that arena slots freed by deletions are reused first.
+    treap_node* arena;
+    size_t arena_capacity;  // slots
+    size_t arena_bytes;     // mapped length
+    treap_node* arena_free;  // free slots, linked through `left`
+    size_t arena_num_free;
+    size_t num_placed;  // nodes allocated since the last compact(), wherever they went
+
+    HotKeyCache<treap_node>* cache;  // consulted by search(); NULL => disabled
+
+    int promote_one_in;  // adaptive mode: promote 1 in this many found searches; 0 => static
+
+    InsertBuffer* buffer;  // insertions not yet merged into the tree; NULL => disabled
+
+    double purge_ratio;     // lazy deletion: purge once this share of nodes are tombstones;
+                            // 0 => eager deletion
+    size_t num_tombstones;  // nodes marked deleted but still linked (counted in num_nodes)
+#ifdef TREAP_STATS
+    treap_stats stats;
+
+    // Record the depth of the node an operation accessed, given the nodes visited to reach it
+    void record_access(const uint64_t visited) {
+        const uint64_t depth = visited > 0 ? visited - 1 : 0;
+        stats.depth_total += depth;
+        stats.depth_histogram[min(depth, (uint64_t)TREAP_STATS_MAX_DEPTH - 1)]++;
+    }
+#endif
+
+    bool in_arena(const treap_node* node) const {
+        return arena != NULL && (uintptr_t)node >= (uintptr_t)arena &&
+               (uintptr_t)node < (uintptr_t)(arena + arena_capacity);
+    }
+
+    treap_node* alloc_node(const element e, const int priority) {
+        num_placed++;
+        if (arena_free != NULL) {
+            treap_node* slot = arena_free;
+            arena_free = slot->left;
+            arena_num_free--;
+            return new (slot) treap_node(e, priority);
+        }
+        return new treap_node(e, priority);
+    }
+
+    void free_node(treap_node* node) {
+        if (in_arena(node)) {
+            node->left = arena_free;
+            arena_free = node;
+            arena_num_free++;
+        } else {
+            delete (node);
+        }
+    }
+
+    void release_arena() {
+        if (arena != NULL) {
+            munmap(arena, arena_bytes);
+        }
+        arena = NULL;
+        arena_capacity = 0;
+        arena_bytes = 0;
+        arena_free = NULL;
+        arena_num_free = 0;
+        num_placed = 0;
+    }
+
+    // Core helper function for compact: appends the nodes of the subtree at `root` that are
+    // fewer than `height` levels below it, in van Emde Boas order
+    void veb_layout(treap_node* root, const int height, vector<treap_node*>& out) {
+        if (height <= 1) {
+            out.push_back(root);
+            return;
+        }
+        const int top = height / 2;
+        veb_layout(root, top, out);
+
+        // Roots of the bottom subtrees, left to right
+        vector<treap_node*> frontier;
+        vector<pair<treap_node*, int> > stack(1, make_pair(root, 0));
+        while (!stack.empty()) {
+            treap_node* node = stack.back().first;
+            const int depth = stack.back().second;
+            stack.pop_back();
+            if (depth == top) {
+                frontier.push_back(node);
+                continue;
+            }
+            if (node->right != NULL) {
+                stack.push_back(make_pair(node->right, depth + 1));
+            }
+            if (node->left != NULL) {
+                stack.push_back(make_pair(node->left, depth + 1));
+            }
+        }
+        for (size_t i = 0; i < frontier.size(); i++) {
+            veb_layout(frontier[i], height - top, out);
+        }
+    }
+
+    // Core helper function for compact: every node in pre-order
+    void dfs_layout(vector<treap_node*>& out) {
+        vector<treap_node*> stack(1, head);
+        while (!stack.empty()) {
+            treap_node* node = stack.back();
+            stack.pop_back();
+            out.push_back(node);
+            if (node->right != NULL) {
+                stack.push_back(node->right);
+            }
+            if (node->left != NULL) {
+                stack.push_back(node->left);
+            }
+        }
+    }
+
+    // Core helper function for insertion operation
+    treap_node* insert_node(treap_node* head, treap_node* n) {
+        if (head == NULL) {
+            return n;
+        }
+        TREAP_STAT(stats.nodes_visited++; stats.comparisons++);
+        // perform bst insert
+        if (n->get_key() <= head->get_key()) {  // TODO: Can use id to break ties for '==' case
+            if (head->left == NULL) {           // insert here
+                head->left = n;
+            } else {  // recurse left
+                head->left = insert_node(head->left, n);
+            }
+        } else {
+            if (head->right == NULL) {  // insert here
+                head->right = n;
+            } else {  // recurse left
+                head->right = insert_node(head->right, n);
+            }
+        }
+
+        // TODO: Could move this into the bst insert logic. Might be slightly faster
+        //  if we inserted: fix the heap condition with rotations, then return the new head
+        if (head->left != NULL && head->left->priority < head->priority) {
+            return rotate_right(head);
+        } else if (head->right != NULL && head->right->priority < head->priority) {
+            return rotate_left(head);
+        }
+
+        // no rotations: return the original head
+        return head;
+    }
+
+    // Core helper function for search operation
+    treap_node* search_node(treap_node* head, const int key) {
+        TREAP_STAT(stats.nodes_visited++; stats.comparisons++);
+        if (head->get_key() == key) {
+            return head;
+        }
+        TREAP_STAT(stats.comparisons++);
+        if (key < head->get_key() && head->left != NULL) {  // go left
+            return search_node(head->left, key);
+        }
+        TREAP_STAT(stats.comparisons++);
+        if (head->get_key() < key && head->right != NULL) {  // go right
+            return search_node(head->right, key);
+        }
+        return NULL;
+    }
+
+    // Core helper function for search with tombstones: first live node with key. Equal keys can
+    // sit on either side of a marked node, so both of its subtrees are searched.
+    treap_node* search_live(treap_node* head, const int key) {
+        while (head != NULL) {
+            TREAP_STAT(stats.nodes_visited++; stats.comparisons++);
+            if (key < head->get_key()) {
+                head = head->left;
+            } else if (head->get_key() < key) {
+                head = head->right;
+            } else if (!head->deleted) {
+                return head;
+            } else {
+                treap_node* node = search_live(head->left, key);
+                if (node != NULL) {
+                    return node;
+                }
+                head = head->right;
+            }
+        }
+        return NULL;
+    }
+
+    // Core helper function for deletion operation in lazy mode: mark the first live node with
+    // key, and purge once tombstones pass purge_ratio
+    void delet_lazy(const int key) {
+        TREAP_STAT(const uint64_t visited = stats.nodes_visited);
+        treap_node* node = search_live(head, key);
+        if (node == NULL) {
+            return;
+        }
+        TREAP_STAT(stats.deletes++; record_access(stats.nodes_visited - visited));
+        node->deleted = true;
+        num_tombstones++;
+        if (num_tombstones > purge_ratio * num_nodes) {
+            purge();
+        }
+    }
+
+    // Core helper function for purge: appends the live nodes of the subtree in key order and
+    // frees the tombstones
+    void collect_live(treap_node* head, vector<treap_node*>& out) {
+        vector<treap_node*> stack;
+        while (head != NULL || !stack.empty()) {
+            while (head != NULL) {
+                stack.push_back(head);
+                head = head->left;
+            }
+            treap_node* node = stack.back();
+            stack.pop_back();
+            head = node->right;
+            if (node->deleted) {
+                free_node(node);
+            } else {
+                node->left = NULL;
+                node->right = NULL;
+                out.push_back(node);
+            }
+        }
+    }
+
+    // Core helper function for batch insertion and purge: link nodes sorted by key into the
+    // treap their priorities define, in O(n) (a Cartesian tree built along its right spine)
+    treap_node* build_sorted(const vector<treap_node*>& nodes) {
+        vector<treap_node*> spine;  // right spine of the treap built so far, root first
+        for (size_t i = 0; i < nodes.size(); i++) {
+            treap_node* node = nodes[i];
+            treap_node* last = NULL;
+            while (!spine.empty() && spine.back()->priority > node->priority) {
+                last = spine.back();
+                spine.pop_back();
+            }
+            node->left = last;
+            if (!spine.empty()) {
+                spine.back()->right = node;
+            }
+            spine.push_back(node);
+        }
+        return spine.empty() ? NULL : spine.front();
+    }
+
+    // Core helper function for priority changes: rotate node down past its smaller-priority
+    // child until neither child has a smaller priority. Returns the new subtree root.
+    treap_node* sift_down(treap_node* node) {
+        treap_node* child = node->left;
+        if (child == NULL || (node->right != NULL && node->right->priority < child->priority)) {
+            child = node->right;
+        }
+        if (child == NULL || child->priority >= node->priority) {
+            return node;
+        }
+        treap_node* top;
+        if (child == node->left) {
+            top = rotate_right(node);
+            top->right = sift_down(node);
+        } else {
+            top = rotate_left(node);
+            top->left = sift_down(node);
+        }
+        return top;
+    }
+
+    // Core helper function for priority changes: restore heap order after the priority of
+    // `target` was lowered (rotate it up) or raised (rotate it down). target is found by identity
+    // along the search path for `key`: below a tombstone with that key it can be on either side,
+    // so the left subtree is tried first, as in search_live. Sets found once target is reached;
+    // subtrees that do not hold it are left unchanged. Returns the new subtree root.
+    treap_node* reprioritise_node(treap_node* head, treap_node* target, const int key,
+                                  bool& found) {
+        if (head == NULL) {
+            return NULL;
+        }
+        if (head == target) {
+            found = true;
+            return sift_down(head);
+        }
+        if (key <= head->get_key()) {
+            head->left = reprioritise_node(head->left, target, key, found);
+            if (found) {
+                if (head->left->priority < head->priority) {
+                    head = rotate_right(head);
+                }
+                return head;
+            }
+            if (key < head->get_key()) {
+                return head;
+            }
+        }
+        head->right = reprioritise_node(head->right, target, key, found);
+        if (found && head->right->priority < head->priority) {
+            head = rotate_left(head);
+        }
+        return head;
+    }
+
+    // Core helper function for batch insertion: split the subtree at head into the nodes before
+    // pivot (returned) and the rest (into right). Equal keys are ordered by id, which is
+    // independent of priority; ordering them by side of the pivot would tie their in-order
+    // position to their priority and grow a path per duplicated key.
+    treap_node* split_node(treap_node* head, const element& pivot, treap_node*& right) {
+        if (head == NULL) {
+            right = NULL;
+            return NULL;
+        }
+        if (head->get_key() < pivot.KEY ||
+            (head->get_key() == pivot.KEY && head->get_id() < pivot.ID)) {
+            head->right = split_node(head->right, pivot, right);
+            return head;
+        }
+        treap_node* upper;
+        treap_node* lower = split_node(head->left, pivot, upper);
+        head->left = upper;
+        right = head;
+        return lower;
+    }
+
+    // Core helper function for batch insertion: union of two treaps. The root with the smaller
+    // priority stays on top and the other treap is split around its key, so each node keeps its
+    // priority and the result is the treap those priorities define.
+    treap_node* union_node(treap_node* a, treap_node* b) {
+        if (a == NULL) {
+            return b;
+        }
+        if (b == NULL) {
+            return a;
+        }
+        if (b->priority < a->priority) {
+            swap(a, b);
+        }
+        treap_node* upper;
+        treap_node* lower = split_node(b, a->elem, upper);
+        a->left = union_node(a->left, lower);
+        a->right = union_node(a->right, upper);
+        return a;
+    }
+
+    // Core helper function for range scans: in-order visit of keys in [lo, hi]. Equal keys can
+    // sit on either side of a node after rotations, so both bounds are inclusive.
+    template <class Visitor>
+    void range_node(treap_node* head, const int lo, const int hi, Visitor& visit) {
+        if (head == NULL) {
+            return;
+        }
+        TREAP_STAT(stats.nodes_visited++; stats.comparisons += 2);
+        const int key = head->get_key();
+        if (lo <= key) {
+            range_node(head->left, lo, hi, visit);
+        }
+        if (lo <= key && key <= hi && !head->deleted) {
+            visit(head->elem);
+        }
+        if (key <= hi) {
+            range_node(head->right, lo, hi, visit);
+        }
+    }
+
+    treap_node* rotate_left(treap_node* head) {
+        TREAP_STAT(stats.rotations++);
+        return treap_rotate_left(head);
+    }
+
+    treap_node* rotate_right(treap_node* head) {
+        TREAP_STAT(stats.rotations++);
+        return treap_rotate_right(head);
+    }
+
+    treap_node* search_parent(treap_node* parent, treap_node* node, const int key) {
+        TREAP_STAT(stats.nodes_visited++; stats.comparisons++);
+        if (parent != NULL && node->get_key() == key) {
+            node->priority = INT_MAX;  // mark for deletion
+            return parent;
+        }
+        TREAP_STAT(stats.comparisons++);
+        if (key < node->get_key() && node->left != NULL) {  // go left
+            return search_parent(node, node->left, key);
+        }
+        TREAP_STAT(stats.comparisons++);
+        if (node->get_key() < key && node->right != NULL) {  // go right
+            return search_parent(node, node->right, key);
+        }
+        return NULL;
+    }
+
+    bool is_leaf_node(treap_node* node) {
+        if (node == NULL) {
+            cout << "Unexpected check of node being a leaf";
+            return false;
+        }
+        if (node->left == NULL && node->right == NULL) return true;
+        return false;
+    }
+
+    bool only_has_left_child(treap_node* node) {
+        if (node->left != NULL && node->right == NULL) {
+            return true;
+        }
+        return false;
+    }
+
+    bool only_has_right_child(treap_node* node) {
+        if (node->left == NULL && node->right != NULL) {
+            return true;
+        }
+        return false;
+    }
+
+    bool left_smaller_than_right(treap_node* node) {
+        // NOTE: Assumes that left and right both exist
+        assert(("ERROR: Expected left and right to both exist",
+                node->left != NULL && node->right != NULL));
+
+        if ((node->left->priority < node->right->priority) ||  // priority
+            (node->left->priority == node->right->priority &&  // tiebreak using key
+             node->left->get_key() < node->right->get_key())) {
+            return true;
+        }
+        return false;
+    }
+
+    // Core helper function for deletion operation: removes `node` from the top of its subtree by
+    // rotating it down past its smaller-priority child until it has at most one child, then
+    // splicing it out. Returns the new root of the subtree. Works on the node itself rather than
+    // re-finding its key after every rotation, which could pick up a duplicate of the key instead.
+    treap_node* delete_node(treap_node* node) {
+        if (is_leaf_node(node)) {  // is leaf => delete
+            free_node(node);
+            num_nodes--;
+            return NULL;
+        }
+        if (only_has_right_child(node) || only_has_left_child(node)) {  // splice out
+            treap_node* child = (node->left != NULL) ? node->left : node->right;
+            free_node(node);
+            num_nodes--;
+            return child;
+        }
+        treap_node* top;
+        if (left_smaller_than_right(node)) {
+            top = rotate_right(node);
+            top->right = delete_node(node);
+        } else {  // right smaller than left
+            top = rotate_left(node);
+            top->left = delete_node(node);
+        }
+        return top;
+    }
+
+    // Core helper function for heigh and node depth
+    int get_height_and_depths_e0(treap_node* node, int* total_depths, int depth) {
+        if (node == NULL) {
+            return depth;
+        }
+        total_depths[node->get_key()] += depth;
+        return max(get_height_and_depths_e0(node->left, total_depths, depth + 1),
+                   get_height_and_depths_e0(node->right, total_depths, depth + 1));
+    }
+
+    // Core helper function for node depth
+    int get_all_node_depths(treap_node* node, int curr_id, int curr_depth, int* depth_array) {
+        if (node == NULL) {
+            return curr_id;
+        }
+        depth_array[curr_id] = curr_depth;
+        curr_id = get_all_node_depths(node->left, curr_id + 1, curr_depth + 1, depth_array);
+        curr_id = get_all_node_depths(node->right, curr_id, curr_depth + 1,
+                                      depth_array);  // TODO: Double-check increment of curr_id
+        return curr_id;
+    }
+
+    int find_depth_of_key_node(treap_node* node, const int key, int depth) {
+        if (node == NULL) {
+            return NOT_FOUND;
+        }
+        if (node->get_key() == key) {
+            return depth;
+        }
+        return max(find_depth_of_key_node(node->left, key, depth + 1),
+                   find_depth_of_key_node(node->right, key, depth + 1));
+    }
+
+    void print(treap_node* head, int depth) {
+        for (int i = 0; i < depth; i++) {
+            cout << "_";
+        }
+        if (head == NULL) {
+            cout << "*EMPTY*\n";
+            return;
+        }
+        cout << '(' << head->get_id() << ", " << head->get_key() << ", " << head->priority
+             << ")\n";
+        print(head->left, depth + 1);
+        print(head->right, depth + 1);
+    }
+
+    // A subtree still to be validated: every key in it must lie in [lo, hi]. Equal keys may sit on
+    // either side of a node after rotations, so both bounds are inclusive.
+    struct validate_frame {
+        treap_node* node;
+        int lo;
+        int hi;
+        int depth;
+    };
+
+    // Check one node against its bounds and its parent's priority, count it, and push its
+    // children's frames
+    static void validate_node(const validate_frame& f, vector<validate_frame>& pending,
+                              treap_shape& shape) {
+        treap_node* node = f.node;
+        const int key = node->get_key();
+        if (key < f.lo || key > f.hi) {
+            shape.bst_ok = false;
+        }
+        shape.nodes++;
+        if ((size_t)f.depth >= shape.depth_histogram.size()) {
+            shape.depth_histogram.resize(f.depth + 1, 0);
+        }
+        shape.depth_histogram[f.depth]++;
+        if (node->left != NULL) {
+            shape.heap_ok = shape.heap_ok && node->left->priority >= node->priority;
+            pending.push_back({node->left, f.lo, key, f.depth + 1});
+        }
+        if (node->right != NULL) {
+            shape.heap_ok = shape.heap_ok && node->right->priority >= node->priority;
+            pending.push_back({node->right, key, f.hi, f.depth + 1});
+        }
+    }
+
+    // Validate whole subtrees with an explicit stack, so degenerate trees cannot overflow it
+    static void validate_subtrees(const vector<validate_frame>& roots, size_t first, size_t step,
+                                  treap_shape& shape) {
+        vector<validate_frame> stack;
+        for (size_t i = first; i < roots.size(); i += step) {
+            stack.push_back(roots[i]);
+            while (!stack.empty()) {
+                const validate_frame f = stack.back();
+                stack.pop_back();
+                validate_node(f, stack, shape);
+            }
+        }
+    }
+
+    static void merge_shape(treap_shape& into, const treap_shape& from) {
+        into.bst_ok = into.bst_ok && from.bst_ok;
+        into.heap_ok = into.heap_ok && from.heap_ok;
+        into.nodes += from.nodes;
+        if (from.depth_histogram.size() > into.depth_histogram.size()) {
+            into.depth_histogram.resize(from.depth_histogram.size(), 0);
+        }
+        for (size_t d = 0; d < from.depth_histogram.size(); d++) {
+            into.depth_histogram[d] += from.depth_histogram[d];
+        }
+    }
+
+    // Core helper function for save: appends the subtree to `out` in pre-order
+    void save_node(treap_node* node, vector<snapshot_node>& out) {
+        const size_t i = out.size();
+        out.push_back({node->elem, node->priority, 0});
+        if (node->left != NULL) {
+            out[i].links |= SNAPSHOT_HAS_LEFT;
+            save_node(node->left, out);
+        }
+        if (node->right != NULL) {
+            out[i].links |= (uint32_t)out.size() << 1;
+            save_node(node->right, out);
+        }
+    }
+
+    // Core helper function for thaw: rebuilds the subtree rooted at snapshot node i. Links are
+    // checked as they are followed; `remaining` stops a corrupt file that links one node from
+    // several parents from thawing more nodes than it holds.
+    treap_node* thaw_node(const MappedTreap& snap, const uint32_t i, uint64_t& remaining) {
+        if (remaining == 0) {
+            cerr << "Snapshot is corrupt, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        remaining--;
+        const snapshot_node* s = snap.node_at(i);
+        treap_node* node = alloc_node(s->elem, s->priority);
+        const uint32_t left = snap.left_child(i);
+        const uint32_t right = snap.right_child(i);
+        if (left != 0) {
+            node->left = thaw_node(snap, left, remaining);
+        }
+        if (right != 0) {
+            node->right = thaw_node(snap, right, remaining);
+        }
+        return node;
+    }
+
+    // Deallocate all memory
+    void dealloc_head(treap_node* head) {
+        if (head == NULL) return;
+        if (head->left != NULL) {
+            dealloc_head(head->left);
+        }
+        if (head->right != NULL) {
+            dealloc_head(head->right);
+        }
+        free_node(head);
+    }
+
+   public:
+    RandomisedTreap()
+        : head(NULL),
+          num_nodes(0),
+          arena(NULL),
+          arena_capacity(0),
+          arena_bytes(0),
+          arena_free(NULL),
+          arena_num_free(0),
+          num_placed(0),
+          cache(NULL),
+          promote_one_in(0),
+          buffer(NULL),
+          purge_ratio(0),
+          num_tombstones(0) {
+        TREAP_STAT(reset_stats());
+    }
+    ~RandomisedTreap() {
+        dealloc_head(head);
+        release_arena();
+        delete (cache);
+        delete (buffer);
+    }
+
+    RandomisedTreap(const RandomisedTreap&) = delete;
+    RandomisedTreap& operator=(const RandomisedTreap&) = delete;
+
+    // Perform insertion operation
+    void insert(element e) {
+        if (buffer != NULL) {
+            buffer->append(e);
+            if (buffer->full()) {
+                flush_insert_buffer();
+            }
+            return;
+        }
+        insert(e, rng.rand_priority());
+    }
+
+    /* Deadline mode: insert with a caller-supplied priority, e.g. an expiry time, instead of a
+     * random one. The root then always holds the smallest priority, so the treap is a priority
+     * queue and a search tree over the same nodes. Priorities must be below INT_MAX. Operations
+     * stay O(log n) expected as long as priorities are independent of key order. */
+    void insert(element e, const int priority) {
+        treap_node* n = alloc_node(e, priority);
+        num_nodes++;
+        TREAP_STAT(const uint64_t visited = stats.nodes_visited;
+                   const uint64_t rotations = stats.rotations);
+        head = insert_node(head, n);
+        TREAP_STAT(stats.inserts++; record_access(stats.nodes_visited - visited + 1);
+                   stats.insert_rotations += stats.rotations - rotations);
+    }
+
+    // Perform deletion operation
+    void delet(const int key) {
+        if (buffer != NULL) {
+            const int slot = buffer->find(key);
+            if (slot != BUFFER_MISS) {
+                buffer->remove(slot);
+                return;
+            }
+        }
+        if (head == NULL) {
+            return;
+        }
+        if (cache != NULL) {
+            cache->invalidate(key);
+        }
+        if (purge_ratio > 0) {
+            delet_lazy(key);
+            return;
+        }
+        TREAP_STAT(const uint64_t rotations = stats.rotations);
+        TREAP_STAT(stats.nodes_visited++; stats.comparisons++);
+        if (head->get_key() == key) {
+            TREAP_STAT(stats.deletes++; record_access(1));
+            head->priority = INT_MAX;
+            head = delete_node(head);
+            TREAP_STAT(stats.delete_rotations += stats.rotations - rotations);
+            return;
+        }
+        TREAP_STAT(const uint64_t visited = stats.nodes_visited);
+        treap_node* parent = search_parent(NULL, head, key);
+        if (parent == NULL) {
+            return;
+        }
+        // search_parent stops at the parent, so the target is one level further down, on the side
+        // search_parent went
+        TREAP_STAT(stats.deletes++; record_access(stats.nodes_visited - visited + 2));
+        if (key < parent->get_key()) {
+            parent->left = delete_node(parent->left);
+        } else {
+            parent->right = delete_node(parent->right);
+        }
+        TREAP_STAT(stats.delete_rotations += stats.rotations - rotations);
+    }
+
+    // Perform search operation
+    element* search(const int key) {
+        if (buffer != NULL) {
+            const int slot = buffer->find(key);
+            if (slot != BUFFER_MISS) {
+                return buffer->at(slot);
+            }
+        }
+        if (head == NULL) {
+            return NULL;
+        }
+        if (cache != NULL) {
+            treap_node* cached = cache->lookup(key);
+            if (cached != NULL) {
+                TREAP_STAT(stats.searches++);
+                return &cached->elem;
+            }
+        }
+        TREAP_STAT(const uint64_t visited = stats.nodes_visited);
+        treap_node* node = num_tombstones > 0 ? search_live(head, key) : search_node(head, key);
+        TREAP_STAT(stats.searches++);
+        if (node == NULL) {
+            return NULL;
+        }
+        TREAP_STAT(record_access(stats.nodes_visited - visited));
+        if (promote_one_in > 0 && rng.rand_id(promote_one_in) == 1) {
+            // Redraw the priority and keep it if it is smaller: the node can only move up
+            const int priority = rng.rand_priority();
+            if (priority < node->priority) {
+                node->priority = priority;
+                bool found = false;
+                head = reprioritise_node(head, node, key, found);
+            }
+        }
+        if (cache != NULL) {
+            cache->store(key, node);
+        }
+        return &node->elem;
+    }
+
+    // Smallest priority in the treap (the root's), or INT_MAX if it is empty
+    int peek_min_priority() { return head != NULL ? head->priority : INT_MAX; }
+
+    // Element with the smallest priority, or NULL if the treap is empty
+    element* peek_min() { return head != NULL ? &head->elem : NULL; }
+
+    /* Remove every element whose priority is <= now, smallest priority first, appending them to
+     * expired if given. Returns how many were removed. Each removal is a root deletion. */
+    int pop_expired(const int now, vector<element>* expired = NULL) {
+        int count = 0;
+        while (head != NULL && head->priority <= now) {
+            if (head->deleted) {  // already deleted: just unlink it
+                num_tombstones--;
+                head = delete_node(head);
+                continue;
+            }
+            if (expired != NULL) {
+                expired->push_back(head->elem);
+            }
+            if (cache != NULL) {
+                cache->invalidate(head->get_key());
+            }
+            TREAP_STAT(stats.deletes++; record_access(1));
+            head = delete_node(head);
+            count++;
+        }
+        return count;
+    }
+
+    // Set the priority of the element search(key) would find and move it to its place in heap
+    // order. Returns false if the key is absent.
+    bool update_priority(const int key, const int priority) {
+        if (head == NULL) {
+            return false;
+        }
+        treap_node* node = num_tombstones > 0 ? search_live(head, key) : search_node(head, key);
+        if (node == NULL) {
+            return false;
+        }
+        node->priority = priority;
+        bool found = false;
+        head = reprioritise_node(head, node, key, found);
+        return true;
+    }
+
+    // Call visit(element&) for every element with lo <= key <= hi, in key order
+    template <class Visitor>
+    void for_each_in_range(const int lo, const int hi, Visitor visit) {
+        flush_insert_buffer();
+        range_node(head, lo, hi, visit);
+    }
+
+    // Perform range scan: number of elements with lo <= key <= hi
+    int range_scan(const int lo, const int hi) {
+        int count = 0;
+        for_each_in_range(lo, hi, [&count](const element&) { count++; });
+        return count;
+    }
+
+    size_t size() { return num_nodes - num_tombstones + (buffer != NULL ? buffer->size() : 0); }
+
+    /* Insert n elements in one pass: sort them by (key, id), the order split_node gives equal
+     * keys, give them random priorities, build their treap bottom-up in O(n) (a Cartesian tree
+     * over the sorted run) and union it with the tree. The union costs O(n log(size() / n + 1))
+     * expected, against O(n log size()) descents and rotations for n single insertions. */
+    void insert_batch(const element* batch, const size_t n) {
+        if (n == 0) {
+            return;
+        }
+        vector<element> sorted(batch, batch + n);
+        sort(sorted.begin(), sorted.end(),
+             [](const element& a, const element& b) {
+                 return a.KEY < b.KEY || (a.KEY == b.KEY && a.ID < b.ID);
+             });
+
+        vector<treap_node*> nodes(n);
+        for (size_t i = 0; i < n; i++) {
+            nodes[i] = alloc_node(sorted[i], rng.rand_priority());
+        }
+        head = union_node(head, build_sorted(nodes));
+        num_nodes += n;
+        TREAP_STAT(stats.inserts += n);
+    }
+
+    /* Write-optimised mode: insert() appends to an InsertBuffer of `capacity` elements instead
+     * of descending the tree, and a full buffer is merged in with insert_batch(). search() and
+     * delet() check the buffer first (one SIMD scan), so they see buffered elements and a
+     * deleted buffered element never reaches the tree. Range queries, compact() and save()
+     * merge the buffer first. Deadline-mode insert(e, priority) always goes to the tree. */
+    void enable_insert_buffer(const int capacity = INSERT_BUFFER_DEFAULT_CAPACITY) {
+        disable_insert_buffer();
+        buffer = new InsertBuffer(capacity);
+    }
+
+    // Merge the buffer and go back to inserting into the tree directly
+    void disable_insert_buffer() {
+        flush_insert_buffer();
+        delete (buffer);
+        buffer = NULL;
+    }
+
+    // Merge every buffered element into the tree
+    void flush_insert_buffer() {
+        if (buffer != NULL && buffer->size() > 0) {
+            insert_batch(buffer->data(), buffer->size());
+            buffer->clear();
+        }
+    }
+
+    /* Lazy deletion: delet() only marks the node it would remove as a tombstone, without any
+     * rotations, and search() and range queries skip marked nodes. Once more than purge_ratio
+     * of the nodes are tombstones, purge() removes them all at once. purge_ratio = 0 restores
+     * eager deletion and purges what is marked. */
+    void set_lazy_delete(const double purge_ratio) {
+        this->purge_ratio = purge_ratio;
+        if (purge_ratio <= 0) {
+            purge();
+        }
+    }
+
+    size_t tombstones() { return num_tombstones; }
+
+    /* Remove every tombstone in one linear pass: an in-order walk collects the live nodes,
+     * which are relinked with build_sorted() under their current priorities. The result is the
+     * treap those nodes would form anyway, built in O(n) rather than by one rotation-heavy
+     * deletion per tombstone. */
+    void purge() {
+        if (num_tombstones == 0) {
+            return;
+        }
+        if (cache != NULL) {
+            cache->clear();  // cached nodes may be tombstones about to be freed
+        }
+        vector<treap_node*> live;
+        live.reserve(num_nodes - num_tombstones);
+        collect_live(head, live);
+        head = build_sorted(live);
+        num_nodes = live.size();
+        num_tombstones = 0;
+    }
+
+    /* Adaptive mode: every found search, with probability 1/one_in, draws a fresh random
+     * priority for the node and keeps it if it is smaller than the current one, rotating the
+     * node up. A key accessed k times ends up with the minimum of about k/one_in draws, so
+     * frequently accessed keys settle near the root while the treap stays a valid treap, and a
+     * promotion costs at most one rotation per level it climbs. one_in = 0 restores the static
+     * treap (priorities already lowered stay lowered). */
+    void set_adaptive(const int one_in) { promote_one_in = one_in; }
+
+    // Depth of the node search(key) would find (root = 0), or NOT_FOUND. Not counted in stats.
+    int key_depth(const int key) {
+        int depth = 0;
+        for (treap_node* node = head; node != NULL; depth++) {
+            if (node->get_key() == key) {
+                return depth;
+            }
+            node = key < node->get_key() ? node->left : node->right;
+        }
+        return NOT_FOUND;
+    }
+
+    /* Put a HotKeyCache of at least min_sets sets in front of search(). Found keys are cached;
+     * deleting a key drops it and compact() or thaw() clear the cache, since nodes move. */
+    void enable_search_cache(const int min_sets = HOT_CACHE_DEFAULT_SETS) {
+        delete (cache);
+        cache = new HotKeyCache<treap_node>(min_sets);
+    }
+
+    void disable_search_cache() {
+        delete (cache);
+        cache = NULL;
+    }
+
+    // Search cache hits and misses; zero if the cache is disabled
+    hot_cache_stats get_cache_stats() {
+        if (cache == NULL) {
+            hot_cache_stats empty = {0, 0};
+            return empty;
+        }
+        return cache->get_stats();
+    }
+
+    // Bytes requested for nodes (the arena plus individually allocated nodes) and the search
+    // cache, excluding per-allocation malloc overhead
+    size_t bytes_allocated() {
+        const size_t arena_live = arena_capacity - arena_num_free;
+        const size_t cache_bytes = cache != NULL ? cache->bytes_allocated() : 0;
+        const size_t buffer_bytes = buffer != NULL ? buffer->bytes_allocated() : 0;
+        return (arena_capacity + num_nodes - arena_live) * sizeof(treap_node) + cache_bytes +
+               buffer_bytes;
+    }
+
+    /* Estimated share of node storage out of layout order: nodes placed since the last
+     * compact() (in a reused arena slot or anywhere else), plus empty arena slots, relative to
+     * all of them. 0 right after compact(), 1 if it was never called. */
+    double fragmentation() {
+        const size_t scattered = min(num_placed, num_nodes) + arena_num_free;
+        const size_t total = num_nodes + arena_num_free;
+        return total > 0 ? min(1.0, (double)scattered / total) : 0;
+    }
+
+    /* Copy every node into a fresh contiguous arena in `order` (COMPACT_VEB or COMPACT_DFS) and
+     * free the old storage. The tree itself (shape, keys, priorities) is unchanged; only node
+     * addresses move, so pointers to elements from search() are invalidated. With huge_pages
+     * the arena is aligned to and advised for transparent huge pages. Returns false, leaving
+     * the treap as it was, if the arena cannot be mapped. */
+    bool compact(const int order = COMPACT_VEB, const bool huge_pages = false) {
+        flush_insert_buffer();
+        if (head == NULL) {
+            release_arena();
+            return true;
+        }
+
+        vector<treap_node*> layout;
+        layout.reserve(num_nodes);
+        if (order == COMPACT_DFS) {
+            dfs_layout(layout);
+        } else {
+            veb_layout(head, validate().height, layout);
+        }
+
+        size_t bytes = layout.size() * sizeof(treap_node);
+        if (huge_pages) {
+            bytes = (bytes + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        }
+        void* mem = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) {
+            cerr << "Failed to map compacted treap arena\n";
+            return false;
+        }
+#ifdef MADV_HUGEPAGE
+        if (huge_pages) {
+            madvise(mem, bytes, MADV_HUGEPAGE);
+        }
+#endif
+        treap_node* nodes = (treap_node*)mem;
+
+        // Copy nodes in layout order, then park each one's new index in its old priority so the
+        // copies' links (still pointing at old nodes) can be translated
+        for (size_t i = 0; i < layout.size(); i++) {
+            new (&nodes[i]) treap_node(*layout[i]);
+            layout[i]->priority = (int)i;
+        }
+        for (size_t i = 0; i < layout.size(); i++) {
+            if (nodes[i].left != NULL) {
+                nodes[i].left = &nodes[nodes[i].left->priority];
+            }
+            if (nodes[i].right != NULL) {
+                nodes[i].right = &nodes[nodes[i].right->priority];
+            }
+        }
+        head = &nodes[head->priority];
+
+        for (size_t i = 0; i < layout.size(); i++) {
+            if (!in_arena(layout[i])) {
+                delete (layout[i]);
+            }
+        }
+        release_arena();
+        if (cache != NULL) {
+            cache->clear();
+        }
+        arena = nodes;
+        arena_capacity = layout.size();
+        arena_bytes = bytes;
+        return true;
+    }
+
+    // compact() once fragmentation() exceeds threshold. Returns true if it compacted.
+    bool compact_if_fragmented(const double threshold, const int order = COMPACT_VEB,
+                               const bool huge_pages = false) {
+        return fragmentation() > threshold && compact(order, huge_pages);
+    }
+
+    // Bytes of element payload stored
+    size_t bytes_live() { return size() * sizeof(element); }
+
+    int find_depth_of_key(const int key) { return find_depth_of_key_node(head, key, 0); }
+
+    int get_height() { return validate().height; }
+
+    int get_height_and_depths_e0(int* total_depths) {
+        return get_height_and_depths_e0(head, total_depths, 0);
+    }
+
+    int* get_all_node_depths(const int num_nodes) {
+        if (head == NULL) {
+            return NULL;
+        }
+
+        int* depths = (int*)calloc(num_nodes, sizeof(int));
+        get_all_node_depths(head, 0, 0, depths);
+
+        return depths;
+    }
+
+    /* Check BST order (against the bounds set by all ancestors, not just the parent), heap
+     * order and the node count in one iterative pass, collecting the height and depth histogram
+     * on the way. The top of the treap is expanded breadth-first until there are a few subtrees
+     * per thread, then the subtrees are validated on num_threads threads (0 => one per core). */
+    treap_shape validate(int num_threads = 0) {
+        treap_shape shape = {true, true, true, 0, 0, vector<uint64_t>()};
+        if (num_threads <= 0) {
+            num_threads = max(1, (int)thread::hardware_concurrency());
+        }
+        if (num_nodes < 65536) {
+            num_threads = 1;  // not worth starting threads
+        }
+
+        vector<validate_frame> frontier;
+        if (head != NULL) {
+            frontier.push_back({head, INT_MIN, INT_MAX, 0});
+        }
+        while (num_threads > 1 && !frontier.empty() && frontier.size() < (size_t)num_threads * 4) {
+            vector<validate_frame> next;
+            for (size_t i = 0; i < frontier.size(); i++) {
+                validate_node(frontier[i], next, shape);
+            }
+            frontier.swap(next);
+        }
+
+        vector<treap_shape> partial(num_threads, {true, true, true, 0, 0, vector<uint64_t>()});
+        vector<thread> threads;
+        for (int t = 1; t < num_threads; t++) {
+            threads.push_back(thread([&frontier, &partial, t, num_threads]() {
+                validate_subtrees(frontier, t, num_threads, partial[t]);
+            }));
+        }
+        validate_subtrees(frontier, 0, num_threads, partial[0]);
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        for (int t = 0; t < num_threads; t++) {
+            merge_shape(shape, partial[t]);
+        }
+
+        shape.size_ok = shape.nodes == num_nodes;
+        shape.height = (int)shape.depth_histogram.size();
+        return shape;
+    }
+
+    // Height, depth distribution and invariants from validate(), e.g. after a benchmark phase
+    void print_shape(const treap_shape& shape) {
+        uint64_t depth_total = 0;
+        for (size_t d = 0; d < shape.depth_histogram.size(); d++) {
+            depth_total += d * shape.depth_histogram[d];
+        }
+        cout << "Treap shape: nodes=" << shape.nodes << " height=" << shape.height
+             << " mean_depth=" << (shape.nodes > 0 ? (double)depth_total / shape.nodes : 0)
+             << " bst=" << (shape.bst_ok ? "ok" : "FAILED")
+             << " heap=" << (shape.heap_ok ? "ok" : "FAILED")
+             << " size=" << (shape.size_ok ? "ok" : "FAILED") << "\nDepth histogram:";
+        for (size_t d = 0; d < shape.depth_histogram.size(); d++) {
+            cout << ' ' << d << ':' << shape.depth_histogram[d];
+        }
+        cout << "\n\n";
+    }
+
+    bool heap_condition_satisfied() { return validate().heap_ok; }
+
+    bool bst_condition_satisfied() { return validate().bst_ok; }
+
+    void print() { print(head, 0); }
+
+    // Structural counters; all zero unless built with TREAP_STATS
+    treap_stats get_stats() {
+#ifdef TREAP_STATS
+        return stats;
+#else
+        treap_stats empty;
+        memset(&empty, 0, sizeof(empty));
+        return empty;
+#endif
+    }
+
+    void reset_stats() { TREAP_STAT(memset(&stats, 0, sizeof(stats))); }
+
+    // Print a summary of get_stats(); prints nothing unless built with TREAP_STATS
+    void print_stats() {
+#ifdef TREAP_STATS
+        const double ops = max(stats.inserts + stats.deletes + stats.searches, (uint64_t)1);
+        uint64_t accesses = 0;
+        for (int d = 0; d < TREAP_STATS_MAX_DEPTH; d++) {
+            accesses += stats.depth_histogram[d];
+        }
+        cout << "Treap stats: inserts=" << stats.inserts << " deletes=" << stats.deletes
+             << " searches=" << stats.searches << " rotations/insert="
+             << (double)stats.insert_rotations / max(stats.inserts, (uint64_t)1)
+             << " rotations/delete="
+             << (double)stats.delete_rotations / max(stats.deletes, (uint64_t)1)
+             << " comparisons/op=" << stats.comparisons / ops
+             << " nodes_visited/op=" << stats.nodes_visited / ops << " avg_access_depth="
+             << (double)stats.depth_total / max(accesses, (uint64_t)1) << '\n';
+        cout << "Access depth histogram=[";
+        int last = TREAP_STATS_MAX_DEPTH - 1;
+        while (last > 0 && stats.depth_histogram[last] == 0) {
+            last--;
+        }
+        for (int d = 0; d <= last; d++) {
+            cout << stats.depth_histogram[d] << (d < last ? "," : "");
+        }
+        cout << "]\n\n";
+#endif
+    }
+
+    // Write a snapshot that MappedTreap::open_mapped() can serve without rebuilding the treap.
+    // The file is written next to `path` and renamed into place, so readers never see a partial
+    // snapshot. Saving changes this treap: the insert buffer is merged and tombstones are
+    // purged first, so the image holds live nodes only.
+    bool save(const char* path) {
+        flush_insert_buffer();
+        purge();
+        vector<snapshot_node> nodes;
+        if (head != NULL) {
+            save_node(head, nodes);
+        }
+        if (nodes.size() > SNAPSHOT_MAX_NODES) {
+            cerr << "Treap too large for snapshot format\n";
+            return false;
+        }
+
+        const string tmp_path = string(path) + ".tmp";
+        FILE* f = fopen(tmp_path.c_str(), "wb");
+        if (f == NULL) {
+            cerr << "Failed to open " << tmp_path << " for writing\n";
+            return false;
+        }
+        const snapshot_header header = {SNAPSHOT_MAGIC, SNAPSHOT_VERSION, nodes.size()};
+        bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+                  fwrite(nodes.data(), sizeof(snapshot_node), nodes.size(), f) == nodes.size();
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp_path.c_str(), path) != 0) {
+            cerr << "Failed to write snapshot " << path << '\n';
+            remove(tmp_path.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    // Replace the contents of this treap with a writable copy of a mapped snapshot.
+    // The tree shape and priorities are copied as-is, so no rotations are needed.
+    void thaw(const MappedTreap& snap) {
+        dealloc_head(head);
+        release_arena();
+        if (cache != NULL) {
+            cache->clear();
+        }
+        if (buffer != NULL) {
+            buffer->clear();
+        }
+        head = NULL;
+        num_nodes = 0;
+        num_tombstones = 0;
+        if (snap.size() > 0) {
+            uint64_t remaining = snap.size();
+            head = thaw_node(snap, 0, remaining);
+            num_nodes = snap.size() - remaining;
+        }
+    }
+};
+
+/* ******************************************************************************************** *
+ *   DYNAMIC ARRAY
+ * ******************************************************************************************** */
+
+class DynamicArray {
+   private:
+    int count = 0;
+    int capacity = 1;
+    element* list;
+
+    void grow() {
+        capacity *= 2;
+        resize();
+    }
+
+    void shrink() {
+        capacity /= 2;
+        resize();
+    }
+
+    void resize() {
+        element* new_list = (element*)malloc(capacity * sizeof(element));
+        if (new_list == NULL) { // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+
+        for (int i = 0; i < count; i++) {
+            new_list[i] = list[i];
+        }
+        free(list);
+        list = new_list;
+    }
+
+   public:
+    DynamicArray() {
+        list = (element*)malloc(1 * sizeof(element));
+        if (list == NULL) { // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~DynamicArray() { free(list); }
+
+    void insert(element x) {
+        if (count + 1 == capacity) {
+            grow();
+        }
+        list[count++] = x;
+    }
+
+    void delet(int key) {
+        // search for key
+        int pos = search(key);
+        if (pos == NOT_FOUND) {
+            return;
+        }
+
+        // swap with last elem, decrease count
+        element temp = list[pos];
+        count -= 1;
+        list[pos] = list[count];
+        list[count] = temp;
+
+        if (count < (capacity / 4)) {
+            shrink();
+        }
+    }
+
+    int search(int key) {
+        for (int i = 0; i < count; i++) {
+            if (list[i].KEY == key) {
+                return i;
+            }
+        }
+        return NOT_FOUND;
+    }
+
+    // Range scan is a full pass: the list is unordered
+    int range_scan(int lo, int hi) {
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            found += (lo <= list[i].KEY && list[i].KEY <= hi);
+        }
+        return found;
+    }
+
+    size_t size() { return count; }
+
+    size_t bytes_allocated() { return capacity * sizeof(element); }
+
+    size_t bytes_live() { return count * sizeof(element); }
+
+    void print() {
+        for (int i = 0; i < count; i++) {
+            cout << '(' << list[i].ID << ", " << list[i].KEY << ")\n";
+        }
+    }
+};
+
+#endif  // DATA_STRUCTURES_H
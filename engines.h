@@ -0,0 +1,214 @@
+#ifndef ENGINES_H
+#define ENGINES_H
+
+#include <cstdlib>
+#include <map>
+#include <type_traits>
+
+#include "avl_tree.h"
+#include "data_structures.h"
+#include "hashed_array.h"
+#include "lock_free_skiplist.h"
+#include "radix_forest.h"
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   ENGINE CONTRACT
+ *
+ *   Anything the experiment drivers and the benchmark harness time is an engine: a default-
+ *   constructible class with
+ *     void insert(element)                  duplicate keys allowed
+ *     void delet(int key)                   remove one element with key, if there is one
+ *     R search(int key)                     found(R) tells whether the key is present
+ *     int range_scan(int lo, int hi)        number of elements with lo <= key <= hi
+ *     size_t size(), bytes_allocated(), bytes_live()
+ *   and an overload of structure_valid() below. Search results differ (DynamicArray returns an
+ *   index, the treaps an element*, the skip list a bool), so callers only ever go through
+ *   found(). Operations reach an engine through apply_op(), so a new engine needs no timed loop
+ *   of its own, only an entry in the registry at the end of this file.
+ * ******************************************************************************************** */
+
+static inline int found(element* e) { return e != NULL; }
+
+static inline int found(int pos) { return pos != NOT_FOUND; }
+
+static inline int found(bool hit) { return hit; }
+
+// Apply one operation to an engine; every timed loop, the streaming consumer and trace replay
+// dispatch through here. Returns its share of a hit count: 1 for a search that found the key,
+// the number of elements in a range scan's [KEY, KEY + ID], 0 for insertions and deletions.
+template <class Engine>
+static inline int apply_op(Engine& ds, const packed_op& op) {
+    if (op.TYPE == OPTYPE_INSERTION) {
+        ds.insert(op.ELEM);
+    } else if (op.TYPE == OPTYPE_DELETION) {
+        ds.delet(op.ELEM.KEY);
+    } else if (op.TYPE == OPTYPE_RANGE) {
+        return ds.range_scan(op.ELEM.KEY, op.ELEM.KEY + op.ELEM.ID);
+    } else {  // OPTYPE_SEARCH
+        return found(ds.search(op.ELEM.KEY));
+    }
+    return 0;
+}
+
+/* ******************************************************************************************** *
+ *   MULTIMAP ENGINE
+ *
+ *   Reference engine: std::multimap, the standard library's red-black tree.
+ * ******************************************************************************************** */
+
+class MultimapEngine {
+   private:
+    multimap<int, element> map;
+
+    // libstdc++ node: colour, parent, left and right links, then the key and element
+    struct node_layout {
+        int colour;
+        void* links[3];
+        pair<const int, element> value;
+    };
+
+   public:
+    // Perform insertion operation
+    void insert(element e) { map.insert(make_pair(e.KEY, e)); }
+
+    // Perform deletion operation
+    void delet(const int key) {
+        multimap<int, element>::iterator it = map.find(key);
+        if (it != map.end()) {
+            map.erase(it);
+        }
+    }
+
+    // Perform search operation
+    element* search(const int key) {
+        multimap<int, element>::iterator it = map.find(key);
+        return it != map.end() ? &it->second : NULL;
+    }
+
+    // Perform range scan: number of elements with lo <= key <= hi
+    int range_scan(const int lo, const int hi) {
+        if (lo > hi) {
+            return 0;
+        }
+        return (int)distance(map.lower_bound(lo), map.upper_bound(hi));
+    }
+
+    size_t size() { return map.size(); }
+
+    // Estimated from the node layout (excludes per-allocation malloc overhead)
+    size_t bytes_allocated() { return map.size() * sizeof(node_layout); }
+
+    size_t bytes_live() { return map.size() * sizeof(element); }
+};
+
+/* ******************************************************************************************** *
+ *   TREAP VARIANTS
+ *
+ *   RandomisedTreap with one of its optional modes switched on, as engines of their own.
+ * ******************************************************************************************** */
+
+// The "treap-cached" engine: a treap with the hot-key search cache in front of it
+class CachedTreap : public RandomisedTreap {
+   public:
+    CachedTreap() { enable_search_cache(); }
+};
+
+// The "treap-adaptive" engine: found searches promote their node (see set_adaptive)
+class AdaptiveTreap : public RandomisedTreap {
+   public:
+    AdaptiveTreap() { set_adaptive(ADAPTIVE_DEFAULT_ONE_IN); }
+};
+
+// The "treap-buffered" engine: insertions are buffered and merged in sorted batches
+class BufferedTreap : public RandomisedTreap {
+   public:
+    BufferedTreap() { enable_insert_buffer(); }
+};
+
+// The "treap-lazy" engine: deletions leave tombstones, purged in batches
+class LazyTreap : public RandomisedTreap {
+   public:
+    LazyTreap() { set_lazy_delete(LAZY_DEFAULT_PURGE_RATIO); }
+};
+
+/* Work an engine deferred past the last operation. Drivers call it inside the timed region, so
+ * the buffered and lazy treaps pay for their final merge and purge. Returns the tombstones
+ * purged. The treap variants derive from RandomisedTreap, so the overloads are picked with
+ * is_base_of: a plain RandomisedTreap& overload would lose to the template for them. */
+template <class Engine>
+static inline size_t settle_engine(Engine&, false_type) {
+    return 0;
+}
+
+template <class Engine>
+static inline size_t settle_engine(Engine& ds, true_type) {
+    const size_t tombstones = ds.tombstones();
+    ds.flush_insert_buffer();
+    ds.purge();
+    return tombstones;
+}
+
+template <class Engine>
+static inline size_t settle_engine(Engine& ds) {
+    return settle_engine(ds, is_base_of<RandomisedTreap, Engine>());
+}
+
+// Structural check after a run, outside the timed region
+static inline bool structure_valid(RandomisedTreap& ds) { return ds.validate().ok(); }
+
+static inline bool structure_valid(RadixTreapForest& ds) { return ds.validate(); }
+
+static inline bool structure_valid(LockFreeSkipList& ds) { return ds.validate(); }
+
+static inline bool structure_valid(AvlTree& ds) { return ds.validate(); }
+
+static inline bool structure_valid(MultimapEngine&) { return true; }
+
+static inline bool structure_valid(HashedDynamicArray& ds) { return ds.validate(); }
+
+static inline bool structure_valid(DynamicArray&) { return true; }
+
+/* ******************************************************************************************** *
+ *   ENGINE REGISTRY
+ *
+ *   The one list of engines. for_each_engine(visit) calls visit(engine_tag<Engine>(), info) for
+ *   each of them in turn; a generic lambda gets the type back as decltype(tag)::type. The
+ *   benchmark harness finds engines by name here, and the experiments and trace replay run
+ *   every engine marked ENGINE_IN_EXPERIMENTS, in this order.
+ * ******************************************************************************************** */
+
+#define ENGINE_IN_EXPERIMENTS 1  // engine_info::flags: run by experiments 1-4 and trace replay
+
+template <class Engine>
+struct engine_tag {
+    typedef Engine type;
+};
+
+struct engine_info {
+    const char* name;   // as given to --engines
+    const char* label;  // as printed by the experiments
+    int flags;
+};
+
+template <class Visitor>
+static inline void for_each_engine(Visitor visit) {
+    visit(engine_tag<DynamicArray>(), engine_info{"array", "DynamicArray", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<HashedDynamicArray>(),
+          engine_info{"hashed-array", "HashedDynamicArray", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<RandomisedTreap>(),
+          engine_info{"treap", "RandomisedTreap", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<BufferedTreap>(),
+          engine_info{"treap-buffered", "BufferedTreap", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<LazyTreap>(), engine_info{"treap-lazy", "LazyTreap", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<AvlTree>(), engine_info{"avl", "AvlTree", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<MultimapEngine>(),
+          engine_info{"multimap", "MultimapEngine", ENGINE_IN_EXPERIMENTS});
+    visit(engine_tag<CachedTreap>(), engine_info{"treap-cached", "CachedTreap", 0});
+    visit(engine_tag<AdaptiveTreap>(), engine_info{"treap-adaptive", "AdaptiveTreap", 0});
+    visit(engine_tag<RadixTreapForest>(), engine_info{"forest", "RadixTreapForest", 0});
+    visit(engine_tag<LockFreeSkipList>(), engine_info{"skiplist", "LockFreeSkipList", 0});
+}
+
+#endif  // ENGINES_H
@@ -0,0 +1,177 @@
+#ifndef EPOCH_RECLAIM_H
+#define EPOCH_RECLAIM_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+#define EPOCH_MAX_THREADS 256   // threads inside the domain at the same time
+#define EPOCH_RETIRE_BATCH 64   // retirements between attempts to advance the epoch
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   EPOCH-BASED MEMORY RECLAMATION
+ *
+ *   Lock-free structures unlink a node while other threads may still be reading it, so it can
+ *   only be freed once every such reader is gone. Threads wrap each operation in an EpochGuard,
+ *   which publishes the global epoch they started in. A node is retired (not freed) once it is
+ *   unreachable, tagged with the global epoch at that moment. The epoch only advances when
+ *   every active thread has caught up with it, so once it is two ahead of a node's tag no
+ *   thread can still hold that node, and it is freed.
+ *
+ *   There is one domain per process. A thread takes a slot on first use and gives it back when
+ *   it exits; nodes it retired that cannot be freed yet are handed to the domain and freed by a
+ *   later advance.
+ * ******************************************************************************************** */
+
+struct retired_ptr {
+    void* ptr;
+    void (*deleter)(void*);
+    uint64_t epoch;  // global epoch when retired
+};
+
+class EpochDomain {
+   private:
+    struct alignas(64) epoch_slot {
+        atomic<bool> in_use;
+        atomic<bool> active;
+        atomic<uint64_t> epoch;  // global epoch seen on entry, valid while active
+    };
+
+    atomic<uint64_t> global_epoch;
+    epoch_slot slots[EPOCH_MAX_THREADS];
+    mutex orphan_lock;
+    vector<retired_ptr> orphans;  // retired by threads that have exited
+
+    EpochDomain() : global_epoch(0) {
+        for (int s = 0; s < EPOCH_MAX_THREADS; s++) {
+            slots[s].in_use.store(false);
+            slots[s].active.store(false);
+            slots[s].epoch.store(0);
+        }
+    }
+
+    // Advance the global epoch if every active thread has entered the current one. Returns the
+    // global epoch afterwards.
+    uint64_t try_advance() {
+        uint64_t epoch = global_epoch.load();
+        for (int s = 0; s < EPOCH_MAX_THREADS; s++) {
+            if (slots[s].active.load() && slots[s].epoch.load() != epoch) {
+                return epoch;
+            }
+        }
+        global_epoch.compare_exchange_strong(epoch, epoch + 1);
+        return global_epoch.load();
+    }
+
+    // Free every entry of list retired at least two epochs before `epoch`, keeping the rest
+    static void free_safe(vector<retired_ptr>& list, const uint64_t epoch) {
+        size_t kept = 0;
+        for (size_t i = 0; i < list.size(); i++) {
+            if (list[i].epoch + 2 <= epoch) {
+                list[i].deleter(list[i].ptr);
+            } else {
+                list[kept++] = list[i];
+            }
+        }
+        list.resize(kept);
+    }
+
+   public:
+    ~EpochDomain() {
+        for (size_t i = 0; i < orphans.size(); i++) {
+            orphans[i].deleter(orphans[i].ptr);
+        }
+    }
+
+    EpochDomain(const EpochDomain&) = delete;
+    EpochDomain& operator=(const EpochDomain&) = delete;
+
+    static EpochDomain& instance() {
+        static EpochDomain domain;
+        return domain;
+    }
+
+    int acquire_slot() {
+        for (int s = 0; s < EPOCH_MAX_THREADS; s++) {
+            bool expected = false;
+            if (!slots[s].in_use.load() &&
+                slots[s].in_use.compare_exchange_strong(expected, true)) {
+                return s;
+            }
+        }
+        cerr << "More than " << EPOCH_MAX_THREADS << " threads in the epoch domain, aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+
+    // Give the slot back, handing over whatever in limbo cannot be freed yet
+    void release_slot(const int s, vector<retired_ptr>& limbo) {
+        free_safe(limbo, try_advance());
+        if (!limbo.empty()) {
+            lock_guard<mutex> lock(orphan_lock);
+            orphans.insert(orphans.end(), limbo.begin(), limbo.end());
+            limbo.clear();
+        }
+        slots[s].in_use.store(false);
+    }
+
+    void enter(const int s) {
+        slots[s].active.store(true);
+        slots[s].epoch.store(global_epoch.load());
+    }
+
+    void leave(const int s) { slots[s].active.store(false); }
+
+    // Retire ptr into limbo; every EPOCH_RETIRE_BATCH retirements, try to advance and free
+    void retire(vector<retired_ptr>& limbo, void* ptr, void (*deleter)(void*)) {
+        retired_ptr r = {ptr, deleter, global_epoch.load()};
+        limbo.push_back(r);
+        if (limbo.size() % EPOCH_RETIRE_BATCH != 0) {
+            return;
+        }
+        const uint64_t epoch = try_advance();
+        free_safe(limbo, epoch);
+        if (orphan_lock.try_lock()) {
+            free_safe(orphans, epoch);
+            orphan_lock.unlock();
+        }
+    }
+};
+
+// A thread's slot in the domain and its retired nodes, released when the thread exits
+struct epoch_thread {
+    int slot;
+    vector<retired_ptr> limbo;
+
+    epoch_thread() : slot(EpochDomain::instance().acquire_slot()) {}
+    ~epoch_thread() { EpochDomain::instance().release_slot(slot, limbo); }
+
+    static epoch_thread& current() {
+        static thread_local epoch_thread self;
+        return self;
+    }
+};
+
+// Marks the calling thread active for its lifetime: nothing it can reach is freed meanwhile
+class EpochGuard {
+   private:
+    epoch_thread& self;
+
+   public:
+    EpochGuard() : self(epoch_thread::current()) { EpochDomain::instance().enter(self.slot); }
+    ~EpochGuard() { EpochDomain::instance().leave(self.slot); }
+
+    EpochGuard(const EpochGuard&) = delete;
+    EpochGuard& operator=(const EpochGuard&) = delete;
+
+    // Free ptr with deleter once no thread can still be reading it
+    void retire(void* ptr, void (*deleter)(void*)) {
+        EpochDomain::instance().retire(self.limbo, ptr, deleter);
+    }
+};
+
+#endif  // EPOCH_RECLAIM_H
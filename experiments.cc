@@ -1,475 +1,1014 @@
-#include "experiments.h"
-
-using namespace std;
-
-RandIntGenerator rng;
-
-/* ******************************************************************************************** *
- *   TIMER
- * ******************************************************************************************** */
-
-/* @param start csc::time_point start = csc::now();
- * @param end csc::time_point end = csc::now();
- */
-void print_time(csc::time_point start, csc::time_point end, string activity) {
-    const time_t t = csc::to_time_t(end);
-    const chrono::duration<double> elapsed_seconds = end - start;
-    cout << "Finished " << activity << " at " << ctime(&t)
-         << "Elapsed time: " << elapsed_seconds.count() << "s\n\n";
-}
-
-/* ******************************************************************************************** *
- *   EXPERIMENT 0
- * ******************************************************************************************** */
-
-void experiment0_phase(int* total_depths) {
-    const int E0_COUNT = 1024;
-    const int KEY_511 = 511;
-    // Initialise Data Structures
-    DataGenerator dg;
-    RandomisedTreap r_treap;
-
-    // Generate test data
-    cout << "Create 1024 insertions\n";
-    vector<insertion_op> insertions;
-    for (int i = 0; i < E0_COUNT; i++) {
-        insertions.push_back(dg.gen_specific_insertion(i));
-    }
-
-    // shuffle insertions
-    random_device rd;
-    mt19937 engine{rd()};
-    std::shuffle(insertions.begin(), insertions.end(), engine);
-
-    assert(("Expected 1024 insertions", insertions.size() == E0_COUNT));
-
-    cout << "Insert 1024 elements into RandomisedTreap\n";
-    for (int i = 0; i < E0_COUNT; i++) {
-        r_treap.insert(insertions[i].ELEM);
-    }
-
-    // Print results
-    cout << "Treap_height=" << r_treap.get_height() << "\n";
-    // int* depths = r_treap.get_all_node_depths(E0_COUNT); // DELETE:
-    cout << "KEY 512 Depth=" << r_treap.find_depth_of_key(KEY_511);
-    r_treap.get_height_and_depths_e0(total_depths);
-
-    // DELETE:
-    // cout << "Node_depths=";
-    // for (int i = 0; i < E0_COUNT; i++) {
-    //     cout << depths[i] << ",";
-    // }
-    // cout << "\n";
-
-    // free(depths);
-}
-
-void experiment0() {
-    const int E0_COUNT = 1024;
-    const int NUM_TRIALS = 100;
-    int* total_depths = (int*)calloc(E0_COUNT, sizeof(int));
-
-    for (int i = 0; i < NUM_TRIALS; i++) {
-        experiment0_phase(total_depths);
-    }
-
-    cout << "average_depths=[";
-    for (int i = 0; i < E0_COUNT; i++) {
-        cout << (total_depths[i] / NUM_TRIALS) << ", ";
-    }
-    cout << "]\n";
-
-    free(total_depths);
-}
-
-/* ******************************************************************************************** *
- *   EXPERIMENT 1
- * ******************************************************************************************** */
-
-void experiment1_phase(const int num_insertions) {
-    // Initialise Data Structures
-    DataGenerator dg;
-    DynamicArray dyn_array;
-    RandomisedTreap r_treap;
-
-    // Generate insertions
-    insertion_op* insertions = (insertion_op*)malloc(num_insertions * sizeof(insertion_op));
-    if (insertions == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_insertions; i++) {
-        insertions[i] = dg.gen_insertion();
-    }
-
-    // Start test on DynamicArray
-    cout << num_insertions << " insertions into DynamicArray\n";
-    csc::time_point start_da = csc::now();  // Start timer
-    for (int i = 0; i < num_insertions; i++) {
-        dyn_array.insert(insertions[i].ELEM);
-    }
-    csc::time_point end_da = csc::now();  // Stop timer
-    print_time(start_da, end_da, "insertions into DynamicArray");
-
-    // Start test on RandomisedTreap
-    cout << num_insertions << " insertions into RandomisedTreap\n";
-    csc::time_point start_rt = csc::now();  // Start timer
-    for (int i = 0; i < num_insertions; i++) {
-        r_treap.insert(insertions[i].ELEM);
-    }
-    csc::time_point end_rt = csc::now();  // Stop timer
-    print_time(start_rt, end_rt, "insertions into RandomisedTreap");
-
-    free(insertions);
-}
-
-void experiment1() {
-    cout << "==Experiment 1==\n"
-         << "> Num insertions (L) = 100000\n";
-    experiment1_phase(100000);
-    cout << "> END 0.1M\n\n";
-
-    cout << "> Num insertions (L) = 200000\n";
-    experiment1_phase(200000);
-    cout << "> END 0.2M\n\n";
-
-    cout << "> Num insertions (L) = 500000\n";
-    experiment1_phase(500000);
-    cout << "> END 0.5M\n\n";
-
-    cout << "> Num insertions (L) = 800000\n";
-    experiment1_phase(800000);
-    cout << "> END 0.8M\n\n";
-
-    cout << "> Num insertions (L) = 1000000\n";
-    experiment1_phase(1000000);
-    cout << "> END 1M\n\n";
-}
-
-/* ******************************************************************************************** *
- *   EXPERIMENT 2
- * ******************************************************************************************** */
-
-void experiment2_phase(const int num_insertions, const int num_deletions) {
-    const int NUM_OPERATIONS = 1000000;
-    assert(("Expected num_insertions + num_deletions == NUM_OPERATIONS",
-            num_insertions + num_deletions == NUM_OPERATIONS));
-
-    // Initialise Data Structures
-    DataGenerator dg;
-    DynamicArray dyn_array;
-    RandomisedTreap r_treap;
-
-    // Generate update sequence
-    insertion_op* insertions = (insertion_op*)malloc(num_insertions * sizeof(insertion_op));
-    if (insertions == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_insertions; i++) {
-        insertions[i] = dg.gen_insertion();
-    }
-
-    deletion_op* deletions = (deletion_op*)malloc(num_deletions * sizeof(deletion_op));
-    if (deletions == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_deletions; i++) {
-        deletions[i] = dg.gen_deletion();
-    }
-
-    vector<int> updates = rng.rand_update_sequence2(
-        NUM_OPERATIONS, OPTYPE_INSERTION, num_insertions, OPTYPE_DELETION, num_deletions);
-
-    // Start test on DynamicArray
-    int next_insertion = 0;
-    int next_deletion = 0;
-    cout << NUM_OPERATIONS << " insertions, deletions on DynamicArray\n";
-    csc::time_point start_da = csc::now();  // Start timer
-    for (int i = 0; i < NUM_OPERATIONS; i++) {
-        if (updates[i] == OPTYPE_INSERTION) {
-            dyn_array.insert(insertions[next_insertion++].ELEM);
-        } else {  // OPTYPE_DELETION
-            dyn_array.delet(deletions[next_deletion++].KEY);
-        }
-    }
-    csc::time_point end_da = csc::now();  // Stop timer
-    print_time(start_da, end_da, "insertions, deletions on DynamicArray");
-
-    assert(("Insertions not all completed", next_insertion == num_insertions));
-    assert(("Deletions not all completed", next_deletion == num_deletions));
-
-    // Start test on RandomisedTreap
-    next_insertion = 0;
-    next_deletion = 0;
-    cout << NUM_OPERATIONS << " insertions, deletions on RandomisedTreap\n";
-    csc::time_point start_rt = csc::now();  // Start timer
-    for (int i = 0; i < NUM_OPERATIONS; i++) {
-        if (updates[i] == OPTYPE_INSERTION) {
-            r_treap.insert(insertions[next_insertion++].ELEM);
-        } else {  // OPTYPE_DELETION
-            r_treap.delet(deletions[next_deletion++].KEY);
-        }
-    }
-    csc::time_point end_rt = csc::now();  // Stop timer
-    print_time(start_rt, end_rt, "insertions, deletions on RandomisedTreap");
-
-    assert(("Insertions not all completed", next_insertion == num_insertions));
-    assert(("Deletions not all completed", next_deletion == num_deletions));
-    // assert(("Heap condition was not satisfied", r_treap.heap_condition_satisfied()));
-    assert(("BST condition was not satisfied", r_treap.bst_condition_satisfied()));
-
-    free(insertions);
-    free(deletions);
-}
-
-void experiment2() {
-    cout << "==Experiment 2==\n"
-         << "> Deletion Probability = 0.1%\n";
-    experiment2_phase(999000, 1000);
-    cout << "> END 0.1%\n\n";
-
-    cout << "> Deletion Probability = 0.5%\n";
-    experiment2_phase(995000, 5000);
-    cout << "> END 0.5%\n\n";
-
-    cout << "> Deletion Probability = 1%\n";
-    experiment2_phase(990000, 10000);
-    cout << "> END 1%\n\n";
-
-    cout << "> Deletion Probability = 5%\n";
-    experiment2_phase(950000, 50000);
-    cout << "> END 5%\n\n";
-
-    cout << "> Deletion Probability = 10%\n";
-    experiment2_phase(900000, 100000);
-    cout << "> END 10%\n\n";
-}
-
-/* ******************************************************************************************** *
- *   EXPERIMENT 3
- * ******************************************************************************************** */
-
-void experiment3_phase(const int num_insertions, const int num_searches) {
-    const int NUM_OPERATIONS = 1000000;
-    assert(("Expected num_insertions + num_searches == NUM_OPERATIONS",
-            num_insertions + num_searches == NUM_OPERATIONS));
-
-    // Initialise Data Structures
-    DataGenerator dg;
-    DynamicArray dyn_array;
-    RandomisedTreap r_treap;
-
-    // Generate update sequence
-    insertion_op* insertions = (insertion_op*)malloc(num_insertions * sizeof(insertion_op));
-    if (insertions == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_insertions; i++) {
-        insertions[i] = dg.gen_insertion();
-    }
-
-    search_op* searches = (search_op*)malloc(num_searches * sizeof(search_op));
-    if (searches == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_searches; i++) {
-        searches[i] = dg.gen_search();
-    }
-
-    vector<int> updates = rng.rand_update_sequence2(NUM_OPERATIONS, OPTYPE_INSERTION,
-                                                    num_insertions, OPTYPE_SEARCH, num_searches);
-
-    // Start test on DynamicArray
-    int next_insertion = 0;
-    int next_search = 0;
-    cout << NUM_OPERATIONS << " insertions, searches on DynamicArray\n";
-    const csc::time_point start_da = csc::now();  // Start timer
-    for (int i = 0; i < NUM_OPERATIONS; i++) {
-        if (updates[i] == OPTYPE_INSERTION) {
-            dyn_array.insert(insertions[next_insertion++].ELEM);
-        } else {  // OPTYPE_SEARCH
-            dyn_array.search(searches[next_search++].KEY);
-        }
-    }
-    const csc::time_point end_da = csc::now();  // Stop timer
-    print_time(start_da, end_da, "insertions, searches on DynamicArray");
-
-    assert(("Insertions not all completed", next_insertion == num_insertions));
-    assert(("Searches not all completed", next_search == num_searches));
-
-    // Start test on RandomisedTreap
-    next_insertion = 0;
-    next_search = 0;
-    cout << NUM_OPERATIONS << " insertions, searches on RandomisedTreap\n";
-    const csc::time_point start_rt = csc::now();  // Start timer
-    for (int i = 0; i < NUM_OPERATIONS; i++) {
-        if (updates[i] == OPTYPE_INSERTION) {
-            r_treap.insert(insertions[next_insertion++].ELEM);
-        } else {  // OPTYPE_SEARCH
-            r_treap.search(searches[next_search++].KEY);
-        }
-    }
-    const csc::time_point end_rt = csc::now();  // Stop timer
-    print_time(start_rt, end_rt, "insertions, searches on RandomisedTreap");
-
-    assert(("Insertions not all completed", next_insertion == num_insertions));
-    assert(("Searches not all completed", next_search == num_searches));
-    // assert(("Heap condition was not satisfied", r_treap.heap_condition_satisfied()));
-    assert(("BST condition was not satisfied", r_treap.bst_condition_satisfied()));
-
-    free(insertions);
-    free(searches);
-}
-
-void experiment3() {
-    cout << "==Experiment 3==\n"
-         << "> Search Probability = 0.1%\n";
-    experiment3_phase(999000, 1000);
-    cout << "> END 0.1%\n\n";
-
-    cout << "> Search Probability = 0.5%\n";
-    experiment3_phase(995000, 5000);
-    cout << "> END 0.5%\n\n";
-
-    cout << "> Search Probability = 1%\n";
-    experiment3_phase(990000, 10000);
-    cout << "> END 1%\n\n";
-
-    cout << "> Search Probability = 5%\n";
-    experiment3_phase(950000, 50000);
-    cout << "> END 5%\n\n";
-
-    cout << "> Search Probability = 10%\n";
-    experiment3_phase(900000, 100000);
-    cout << "> END 10%\n\n";
-}
-
-/* ******************************************************************************************** *
- *   EXPERIMENT 4
- * ******************************************************************************************** */
-
-void experiment4_phase(const int num_operations, const int num_insertions, const int num_deletions,
-                       const int num_searches) {
-    assert(("Expected num_insertions + num_deletions + num_searches == num_operations",
-            (num_insertions + num_deletions + num_searches) == num_operations));
-
-    // Initialise Data Structures
-    DataGenerator dg;
-    DynamicArray dyn_array;
-    RandomisedTreap r_treap;
-
-    // Generate update sequence
-    insertion_op* insertions = (insertion_op*)malloc(num_insertions * sizeof(insertion_op));
-    if (insertions == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_insertions; i++) {
-        insertions[i] = dg.gen_insertion();
-    }
-
-    deletion_op* deletions = (deletion_op*)malloc(num_deletions * sizeof(deletion_op));
-    if (deletions == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_deletions; i++) {
-        deletions[i] = dg.gen_deletion();
-    }
-
-    search_op* searches = (search_op*)malloc(num_searches * sizeof(search_op));
-    if (searches == NULL) {  // Check allocation successful
-        cerr << "Failed to allocate, aborting...\n";
-        exit(EXIT_FAILURE);
-    }
-
-    for (int i = 0; i < num_searches; i++) {
-        searches[i] = dg.gen_search();
-    }
-
-    vector<int> updates =
-        rng.rand_update_sequence3(num_operations, OPTYPE_INSERTION, num_insertions,
-                                  OPTYPE_DELETION, num_deletions, OPTYPE_SEARCH, num_searches);
-
-    // Start test on DynamicArray
-    int next_insertion = 0;
-    int next_deletion = 0;
-    int next_search = 0;
-    cout << num_operations << " insertions, deletions, searches on DynamicArray\n";
-    const csc::time_point start_da = csc::now();  // Start timer
-    for (int i = 0; i < num_operations; i++) {
-        if (updates[i] == OPTYPE_INSERTION) {
-            dyn_array.insert(insertions[next_insertion++].ELEM);
-        } else if (updates[i] == OPTYPE_DELETION) {
-            dyn_array.delet(deletions[next_deletion++].KEY);
-        } else {  // OPTYPE_SEARCH
-            dyn_array.search(searches[next_search++].KEY);
-        }
-    }
-    const csc::time_point end_da = csc::now();  // Stop timer
-    print_time(start_da, end_da, "insertions, deletions, searches on DynamicArray");
-
-    assert(("Insertions not all completed", next_insertion == num_insertions));
-    assert(("Deletions not all completed", next_deletion == num_deletions));
-    assert(("Searches not all completed", next_search == num_searches));
-
-    // Start test on RandomisedTreap
-    next_insertion = 0;
-    next_deletion = 0;
-    next_search = 0;
-    cout << num_operations << " insertions, deletions, searches on RandomisedTreap\n";
-    const csc::time_point start_rt = csc::now();  // Start timer
-    for (int i = 0; i < num_operations; i++) {
-        if (updates[i] == OPTYPE_INSERTION) {
-            r_treap.insert(insertions[next_insertion++].ELEM);
-        } else if (updates[i] == OPTYPE_DELETION) {
-            r_treap.delet(deletions[next_deletion++].KEY);
-        } else {  // OPTYPE_SEARCH
-            r_treap.search(searches[next_search++].KEY);
-        }
-    }
-    const csc::time_point end_rt = csc::now();  // Stop timer
-    print_time(start_rt, end_rt, "insertions, deletions, searches on RandomisedTreap");
-
-    assert(("Insertions not all completed", next_insertion == num_insertions));
-    assert(("Deletions not all completed", next_deletion == num_deletions));
-    assert(("Searches not all completed", next_search == num_searches));
-    assert(("BST condition was not satisfied", r_treap.bst_condition_satisfied()));
-    free(insertions);
-    free(deletions);
-    free(searches);
-}
-
-void experiment4() {
-    cout << "==Experiment 4==\n"
-         << ">  Num. Mixed operations (L) = 100000\n";
-    experiment4_phase(100000, 90000, 5000, 5000);
-    cout << "> END L=0.1M\n\n";
-
-    cout << "> Num. Mixed operations (L) = 200000\n";
-    experiment4_phase(200000, 180000, 10000, 10000);
-    cout << "> END L=0.2M\n\n";
-
-    cout << "> Num. Mixed operations (L) = 500000\n";
-    experiment4_phase(500000, 450000, 25000, 25000);
-    cout << "> END L=0.5M\n\n";
-
-    cout << "> Num. Mixed operations (L) = 800000\n";
-    experiment4_phase(800000, 720000, 40000, 40000);
-    cout << "> END L=0.8M\n\n";
-
-    cout << "> Num. Mixed operations (L) = 1000000\n";
-    experiment4_phase(1000000, 900000, 50000, 50000);
-    cout << "> END L=1M\n\n";
-}
+#include "experiments.h"
+
+using namespace std;
+
+thread_local RandIntGenerator rng;
+
+static trial_config trial_settings;
+
+void configure_trials(const trial_config& config) { trial_settings = config; }
+
+/* ******************************************************************************************** *
+ *   TIMER
+ * ******************************************************************************************** */
+
+/* @param start csc::time_point start = csc::now();
+ * @param end csc::time_point end = csc::now();
+ */
+void print_time(csc::time_point start, csc::time_point end, string activity) {
+    const time_t t = csc::to_time_t(end);
+    const chrono::duration<double> elapsed_seconds = end - start;
+    cout << "Finished " << activity << " at " << ctime(&t)
+         << "Elapsed time: " << elapsed_seconds.count() << "s\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   ENGINE DRIVERS
+ *
+ *   Experiments 1-4 time the same operation sequence on every engine the registry in engines.h
+ *   marks ENGINE_IN_EXPERIMENTS. Each engine runs in a fresh instance through one timed loop,
+ *   so a new engine only has to be registered there.
+ * ******************************************************************************************** */
+
+static volatile int engine_sink;  // keeps search results observable
+
+// Number of operations of each type an engine performed
+struct op_counts {
+    int insertions;
+    int deletions;
+    int searches;
+};
+
+// Checks after the timed loop. The treaps also report their counters and shape.
+template <class Engine>
+static void report_engine(const char* name, Engine& ds, size_t, false_type) {
+    if (!structure_valid(ds)) {
+        cerr << name << " failed validation, aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+}
+
+template <class Engine>
+static void report_engine(const char*, Engine& ds, const size_t purged, true_type) {
+    cout << "Tombstones purged at end: " << purged << '\n';
+    ds.print_stats();
+    const treap_shape shape = ds.validate();
+    ds.print_shape(shape);
+    assert(("Heap condition was not satisfied", shape.heap_ok));
+    assert(("BST condition was not satisfied", shape.bst_ok));
+    assert(("Treap size does not match its nodes", shape.size_ok));
+}
+
+template <class Engine>
+static void report_engine(const char* name, Engine& ds, const size_t purged) {
+    report_engine(name, ds, purged, is_base_of<RandomisedTreap, Engine>());
+}
+
+// Apply ops in order to a fresh Engine and print the time, counters and footprint
+template <class Engine>
+static op_counts run_engine(const char* name, const vector<packed_op>& ops,
+                            const string& activity, PerfCounters& perf) {
+    Engine ds;
+    op_counts counts = {0, 0, 0};
+    int hits = 0;
+    const int num_operations = (int)ops.size();
+
+    cout << num_operations << " " << activity << " on " << name << "\n";
+    const csc::time_point start = csc::now();  // Start timer
+    perf.start();
+    for (int i = 0; i < num_operations; i++) {
+        hits += apply_op(ds, ops[i]);
+        counts.insertions += (ops[i].TYPE == OPTYPE_INSERTION);
+        counts.deletions += (ops[i].TYPE == OPTYPE_DELETION);
+        counts.searches += (ops[i].TYPE == OPTYPE_SEARCH);
+    }
+    const size_t purged = settle_engine(ds);
+    perf.stop();
+    const csc::time_point end = csc::now();  // Stop timer
+    engine_sink = hits;
+    print_time(start, end, activity + " on " + name);
+    perf.print(num_operations);
+    print_footprint(name, ds.size(), ds.bytes_allocated(), ds.bytes_live());
+    report_engine(name, ds, purged);
+    return counts;
+}
+
+// Run ops on every engine, checking each one performed the expected number of operations
+static void run_engines(const vector<packed_op>& ops, const string& activity,
+                        const op_counts expected, PerfCounters& perf) {
+    for_each_engine([&](auto tag, const engine_info& info) {
+        typedef typename decltype(tag)::type Engine;
+        if ((info.flags & ENGINE_IN_EXPERIMENTS) == 0) {
+            return;
+        }
+        const op_counts counts = run_engine<Engine>(info.label, ops, activity, perf);
+        assert(("Insertions not all completed", counts.insertions == expected.insertions));
+        assert(("Deletions not all completed", counts.deletions == expected.deletions));
+        assert(("Searches not all completed", counts.searches == expected.searches));
+    });
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 0
+ * ******************************************************************************************** */
+
+// Adds each key's depth to total_depths. Writes to `out` only, so trials can run in parallel.
+void experiment0_phase(int* total_depths, ostream& out) {
+    const int E0_COUNT = 1024;
+    const int KEY_511 = 511;
+    // Initialise Data Structures
+    DataGenerator dg;
+    RandomisedTreap r_treap;
+
+    // Generate test data
+    out << "Create 1024 insertions\n";
+    vector<insertion_op> insertions;
+    for (int i = 0; i < E0_COUNT; i++) {
+        insertions.push_back(dg.gen_specific_insertion(i));
+    }
+
+    // shuffle insertions
+    rng.shuffle(insertions.begin(), insertions.end());
+
+    assert(("Expected 1024 insertions", insertions.size() == E0_COUNT));
+
+    out << "Insert 1024 elements into RandomisedTreap\n";
+    for (int i = 0; i < E0_COUNT; i++) {
+        r_treap.insert(insertions[i].ELEM);
+    }
+
+    // Print results
+    out << "Treap_height=" << r_treap.get_height() << "\n";
+    // int* depths = r_treap.get_all_node_depths(E0_COUNT); // DELETE:
+    out << "KEY 512 Depth=" << r_treap.find_depth_of_key(KEY_511);
+    r_treap.get_height_and_depths_e0(total_depths);
+
+    // DELETE:
+    // cout << "Node_depths=";
+    // for (int i = 0; i < E0_COUNT; i++) {
+    //     cout << depths[i] << ",";
+    // }
+    // cout << "\n";
+
+    // free(depths);
+}
+
+void experiment0() {
+    const int E0_COUNT = 1024;
+    const int NUM_TRIALS = 100;
+    TrialRunner runner(trial_settings, 0);
+    cout << "Trial seed: " << runner.get_seed() << ", " << runner.num_workers(NUM_TRIALS)
+         << " workers\n";
+
+    // Each trial fills its own depths and output; they are combined in trial order afterwards
+    int* trial_depths = (int*)calloc((size_t)E0_COUNT * NUM_TRIALS, sizeof(int));
+    if (trial_depths == NULL) {  // Check allocation successful
+        cerr << "Failed to allocate, aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+    vector<stringstream> trial_output(NUM_TRIALS);
+    runner.run_parallel(NUM_TRIALS, [trial_depths, &trial_output](const int i) {
+        experiment0_phase(trial_depths + (size_t)i * E0_COUNT, trial_output[i]);
+    });
+
+    int* total_depths = (int*)calloc(E0_COUNT, sizeof(int));
+    for (int i = 0; i < NUM_TRIALS; i++) {
+        cout << trial_output[i].str();
+        for (int key = 0; key < E0_COUNT; key++) {
+            total_depths[key] += trial_depths[(size_t)i * E0_COUNT + key];
+        }
+    }
+    free(trial_depths);
+
+    cout << "average_depths=[";
+    for (int i = 0; i < E0_COUNT; i++) {
+        cout << (total_depths[i] / NUM_TRIALS) << ", ";
+    }
+    cout << "]\n";
+
+    free(total_depths);
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 1
+ * ******************************************************************************************** */
+
+void experiment1_phase(const int num_insertions) {
+    // Initialise Data Structures
+    reset_peak_rss();
+    DataGenerator dg;
+
+    PerfCounters perf;
+
+    // Generate insertions
+    vector<packed_op> ops(num_insertions);
+    for (int i = 0; i < num_insertions; i++) {
+        ops[i].TYPE = OPTYPE_INSERTION;
+        ops[i].ELEM = dg.gen_insertion().ELEM;
+    }
+
+    const op_counts expected = {num_insertions, 0, 0};
+    run_engines(ops, "insertions", expected, perf);
+
+    print_footprint("DataGenerator", dg.live_count(), dg.bytes_allocated(),
+                    dg.live_count() * sizeof(int));
+    print_process_memory("phase");
+}
+
+void experiment1() {
+    TrialRunner runner(trial_settings, 1);
+    cout << "==Experiment 1==\n"
+         << "> Num insertions (L) = 100000\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment1_phase(100000); });
+    cout << "> END 0.1M\n\n";
+
+    cout << "> Num insertions (L) = 200000\n";
+    runner.run_isolated(1, [] { experiment1_phase(200000); });
+    cout << "> END 0.2M\n\n";
+
+    cout << "> Num insertions (L) = 500000\n";
+    runner.run_isolated(2, [] { experiment1_phase(500000); });
+    cout << "> END 0.5M\n\n";
+
+    cout << "> Num insertions (L) = 800000\n";
+    runner.run_isolated(3, [] { experiment1_phase(800000); });
+    cout << "> END 0.8M\n\n";
+
+    cout << "> Num insertions (L) = 1000000\n";
+    runner.run_isolated(4, [] { experiment1_phase(1000000); });
+    cout << "> END 1M\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 2
+ * ******************************************************************************************** */
+
+void experiment2_phase(const int num_insertions, const int num_deletions) {
+    const int NUM_OPERATIONS = 1000000;
+    assert(("Expected num_insertions + num_deletions == NUM_OPERATIONS",
+            num_insertions + num_deletions == NUM_OPERATIONS));
+
+    // Initialise Data Structures
+    reset_peak_rss();
+
+    PerfCounters perf;
+
+    // Generate update sequence. Generation runs on every core; the seed alone determines the
+    // sequence, whatever the number of cores.
+    const ParallelOpGenerator gen(rng.rand_seed(), 0, num_insertions, num_deletions, 0);
+    cout << "Workload seed: " << gen.get_seed() << '\n';
+    const vector<packed_op> ops = gen.gen_operations();
+
+    const op_counts expected = {num_insertions, num_deletions, 0};
+    run_engines(ops, "insertions, deletions", expected, perf);
+
+    print_footprint("Operation sequence", ops.size(), ops.capacity() * sizeof(packed_op),
+                    ops.size() * sizeof(packed_op));
+    print_process_memory("phase");
+}
+
+void experiment2() {
+    TrialRunner runner(trial_settings, 2);
+    cout << "==Experiment 2==\n"
+         << "> Deletion Probability = 0.1%\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment2_phase(999000, 1000); });
+    cout << "> END 0.1%\n\n";
+
+    cout << "> Deletion Probability = 0.5%\n";
+    runner.run_isolated(1, [] { experiment2_phase(995000, 5000); });
+    cout << "> END 0.5%\n\n";
+
+    cout << "> Deletion Probability = 1%\n";
+    runner.run_isolated(2, [] { experiment2_phase(990000, 10000); });
+    cout << "> END 1%\n\n";
+
+    cout << "> Deletion Probability = 5%\n";
+    runner.run_isolated(3, [] { experiment2_phase(950000, 50000); });
+    cout << "> END 5%\n\n";
+
+    cout << "> Deletion Probability = 10%\n";
+    runner.run_isolated(4, [] { experiment2_phase(900000, 100000); });
+    cout << "> END 10%\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 3
+ * ******************************************************************************************** */
+
+void experiment3_phase(const int num_insertions, const int num_searches) {
+    const int NUM_OPERATIONS = 1000000;
+    assert(("Expected num_insertions + num_searches == NUM_OPERATIONS",
+            num_insertions + num_searches == NUM_OPERATIONS));
+
+    // Initialise Data Structures
+    reset_peak_rss();
+    DataGenerator dg;
+
+    PerfCounters perf;
+
+    // Generate update sequence: every insertion is generated before the searches, which then
+    // look up keys from the whole run
+    vector<insertion_op> insertions(num_insertions);
+    for (int i = 0; i < num_insertions; i++) {
+        insertions[i] = dg.gen_insertion();
+    }
+
+    vector<search_op> searches(num_searches);
+    for (int i = 0; i < num_searches; i++) {
+        searches[i] = dg.gen_search();
+    }
+
+    vector<int> updates = rng.rand_update_sequence2(NUM_OPERATIONS, OPTYPE_INSERTION,
+                                                    num_insertions, OPTYPE_SEARCH, num_searches);
+
+    vector<packed_op> ops(NUM_OPERATIONS);
+    int next_insertion = 0;
+    int next_search = 0;
+    for (int i = 0; i < NUM_OPERATIONS; i++) {
+        ops[i].TYPE = updates[i];
+        if (updates[i] == OPTYPE_INSERTION) {
+            ops[i].ELEM = insertions[next_insertion++].ELEM;
+        } else {  // OPTYPE_SEARCH
+            ops[i].ELEM.ID = 0;
+            ops[i].ELEM.KEY = searches[next_search++].KEY;
+        }
+    }
+
+    const op_counts expected = {num_insertions, 0, num_searches};
+    run_engines(ops, "insertions, searches", expected, perf);
+
+    print_footprint("DataGenerator", dg.live_count(), dg.bytes_allocated(),
+                    dg.live_count() * sizeof(int));
+    print_process_memory("phase");
+}
+
+void experiment3() {
+    TrialRunner runner(trial_settings, 3);
+    cout << "==Experiment 3==\n"
+         << "> Search Probability = 0.1%\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment3_phase(999000, 1000); });
+    cout << "> END 0.1%\n\n";
+
+    cout << "> Search Probability = 0.5%\n";
+    runner.run_isolated(1, [] { experiment3_phase(995000, 5000); });
+    cout << "> END 0.5%\n\n";
+
+    cout << "> Search Probability = 1%\n";
+    runner.run_isolated(2, [] { experiment3_phase(990000, 10000); });
+    cout << "> END 1%\n\n";
+
+    cout << "> Search Probability = 5%\n";
+    runner.run_isolated(3, [] { experiment3_phase(950000, 50000); });
+    cout << "> END 5%\n\n";
+
+    cout << "> Search Probability = 10%\n";
+    runner.run_isolated(4, [] { experiment3_phase(900000, 100000); });
+    cout << "> END 10%\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 4
+ * ******************************************************************************************** */
+
+// Run ops on a LockFreeSkipList with num_threads threads, each taking a contiguous chunk. Each
+// thread gets its own core from runner under --pin (else all would share the phase's core).
+void experiment4_skiplist(TrialRunner& runner, const vector<packed_op>& ops,
+                          const int num_threads) {
+    LockFreeSkipList skip_list;
+    const size_t chunk = (ops.size() + num_threads - 1) / num_threads;
+    atomic<int> ready(0);
+    atomic<bool> go(false);
+    vector<thread> threads;
+    for (int t = 0; t < num_threads; t++) {
+        threads.push_back(thread([&runner, &skip_list, &ops, &ready, &go, chunk, t]() {
+            runner.pin_worker(t);
+            const size_t end = min(ops.size(), (t + 1) * chunk);
+            ready++;
+            while (!go.load()) {
+                this_thread::yield();
+            }
+            for (size_t i = t * chunk; i < end; i++) {
+                if (ops[i].TYPE == OPTYPE_INSERTION) {
+                    skip_list.insert(ops[i].ELEM);
+                } else if (ops[i].TYPE == OPTYPE_DELETION) {
+                    skip_list.delet(ops[i].ELEM.KEY);
+                } else {  // OPTYPE_SEARCH
+                    skip_list.search(ops[i].ELEM.KEY);
+                }
+            }
+        }));
+    }
+    while (ready.load() < num_threads) {
+        this_thread::yield();
+    }
+
+    cout << ops.size() << " insertions, deletions, searches on LockFreeSkipList with "
+         << num_threads << " threads\n";
+    const csc::time_point start = csc::now();  // Start timer
+    go.store(true);
+    for (int t = 0; t < num_threads; t++) {
+        threads[t].join();
+    }
+    const csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end,
+               "insertions, deletions, searches on LockFreeSkipList (" + to_string(num_threads) +
+                   " threads)");
+    print_footprint("LockFreeSkipList", skip_list.size(), skip_list.bytes_allocated(),
+                    skip_list.bytes_live());
+    assert(("Skip list invalid after concurrent operations", skip_list.validate()));
+}
+
+void experiment4_phase(TrialRunner& runner, const int num_operations, const int num_insertions,
+                       const int num_deletions, const int num_searches) {
+    assert(("Expected num_insertions + num_deletions + num_searches == num_operations",
+            (num_insertions + num_deletions + num_searches) == num_operations));
+
+    // Initialise Data Structures
+    reset_peak_rss();
+
+    PerfCounters perf;
+
+    // Generate update sequence. Generation runs on every core; the seed alone determines the
+    // sequence, whatever the number of cores.
+    const ParallelOpGenerator gen(rng.rand_seed(), 0, num_insertions, num_deletions,
+                                  num_searches);
+    cout << "Workload seed: " << gen.get_seed() << '\n';
+    const vector<packed_op> ops = gen.gen_operations();
+
+    const op_counts expected = {num_insertions, num_deletions, num_searches};
+    run_engines(ops, "insertions, deletions, searches", expected, perf);
+
+    // Same sequence on the concurrent skip list, split over 1, 2, 4, ... up to --jobs threads
+    // (default: one per core). With more than one thread the interleaving differs from the
+    // sequence, so only throughput is comparable.
+    const int max_threads = trial_settings.jobs > 0
+                                ? trial_settings.jobs
+                                : max(1, (int)thread::hardware_concurrency());
+    for (int num_threads = 1; num_threads < max_threads; num_threads *= 2) {
+        experiment4_skiplist(runner, ops, num_threads);
+    }
+    experiment4_skiplist(runner, ops, max_threads);
+
+    print_footprint("Operation sequence", ops.size(), ops.capacity() * sizeof(packed_op),
+                    ops.size() * sizeof(packed_op));
+    print_process_memory("phase");
+}
+
+void experiment4() {
+    TrialRunner runner(trial_settings, 4);
+    cout << "==Experiment 4==\n"
+         << ">  Num. Mixed operations (L) = 100000\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0,
+                        [&runner] { experiment4_phase(runner, 100000, 90000, 5000, 5000); });
+    cout << "> END L=0.1M\n\n";
+
+    cout << "> Num. Mixed operations (L) = 200000\n";
+    runner.run_isolated(1,
+                        [&runner] { experiment4_phase(runner, 200000, 180000, 10000, 10000); });
+    cout << "> END L=0.2M\n\n";
+
+    cout << "> Num. Mixed operations (L) = 500000\n";
+    runner.run_isolated(2,
+                        [&runner] { experiment4_phase(runner, 500000, 450000, 25000, 25000); });
+    cout << "> END L=0.5M\n\n";
+
+    cout << "> Num. Mixed operations (L) = 800000\n";
+    runner.run_isolated(3,
+                        [&runner] { experiment4_phase(runner, 800000, 720000, 40000, 40000); });
+    cout << "> END L=0.8M\n\n";
+
+    cout << "> Num. Mixed operations (L) = 1000000\n";
+    runner.run_isolated(4,
+                        [&runner] { experiment4_phase(runner, 1000000, 900000, 50000, 50000); });
+    cout << "> END L=1M\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 5
+ * ******************************************************************************************** */
+
+void print_page_faults(page_faults start, page_faults end, const int num_operations) {
+    const long minor = end.minor - start.minor;
+    const long major = end.major - start.major;
+    cout << "Page faults: minor=" << minor << " major=" << major
+         << " per_op=" << (double)(minor + major) / num_operations << '\n';
+}
+
+void experiment5_phase(const int num_operations, const int num_insertions, const int num_deletions,
+                       const int num_searches) {
+    const char* ARENA_PATH = "experiment5_arena.bin";
+    assert(("Expected num_insertions + num_deletions + num_searches == num_operations",
+            (num_insertions + num_deletions + num_searches) == num_operations));
+
+    // Initialise Data Structures
+    reset_peak_rss();
+    DataGenerator dg;
+    ArenaTreap a_treap;
+    unlink(ARENA_PATH);
+    if (!a_treap.open(ARENA_PATH)) {
+        cerr << "Failed to open arena, aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+
+    PerfCounters perf;
+
+    // Generate update sequence
+    insertion_op* insertions = (insertion_op*)malloc(num_insertions * sizeof(insertion_op));
+    deletion_op* deletions = (deletion_op*)malloc(num_deletions * sizeof(deletion_op));
+    search_op* searches = (search_op*)malloc(num_searches * sizeof(search_op));
+    if (insertions == NULL || deletions == NULL || searches == NULL) {  // Check allocation
+        cerr << "Failed to allocate, aborting...\n";
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_insertions; i++) {
+        insertions[i] = dg.gen_insertion();
+    }
+    for (int i = 0; i < num_deletions; i++) {
+        deletions[i] = dg.gen_deletion();
+    }
+    for (int i = 0; i < num_searches; i++) {
+        searches[i] = dg.gen_search();
+    }
+
+    vector<int> updates =
+        rng.rand_update_sequence3(num_operations, OPTYPE_INSERTION, num_insertions,
+                                  OPTYPE_DELETION, num_deletions, OPTYPE_SEARCH, num_searches);
+
+    // Start test on ArenaTreap: treap descents are random accesses into the file
+    int next_insertion = 0;
+    int next_deletion = 0;
+    int next_search = 0;
+    a_treap.advise(ARENA_ADVICE_RANDOM);
+    cout << num_operations << " insertions, deletions, searches on ArenaTreap\n";
+    const page_faults start_pf = get_page_faults();
+    const csc::time_point start_at = csc::now();  // Start timer
+    perf.start();
+    for (int i = 0; i < num_operations; i++) {
+        if (updates[i] == OPTYPE_INSERTION) {
+            a_treap.insert(insertions[next_insertion++].ELEM);
+        } else if (updates[i] == OPTYPE_DELETION) {
+            a_treap.delet(deletions[next_deletion++].KEY);
+        } else {  // OPTYPE_SEARCH
+            a_treap.search(searches[next_search++].KEY);
+        }
+    }
+    perf.stop();
+    const csc::time_point end_at = csc::now();  // Stop timer
+    const page_faults end_pf = get_page_faults();
+    print_time(start_at, end_at, "insertions, deletions, searches on ArenaTreap");
+    perf.print(num_operations);
+    print_page_faults(start_pf, end_pf, num_operations);
+
+    assert(("Insertions not all completed", next_insertion == num_insertions));
+    assert(("Deletions not all completed", next_deletion == num_deletions));
+    assert(("Searches not all completed", next_search == num_searches));
+
+    // Checkpoint: write back every dirty page in file order
+    a_treap.advise(ARENA_ADVICE_SEQUENTIAL);
+    const csc::time_point start_cp = csc::now();  // Start timer
+    a_treap.checkpoint();
+    const csc::time_point end_cp = csc::now();  // Stop timer
+    print_time(start_cp, end_cp, "checkpoint of ArenaTreap");
+    cout << "Arena: nodes=" << a_treap.size() << " file_bytes=" << a_treap.file_bytes()
+         << " height=" << a_treap.get_height() << "\n";
+    print_footprint("ArenaTreap", a_treap.size(), a_treap.file_bytes(),
+                    a_treap.size() * sizeof(element));
+    print_process_memory("phase");
+
+    a_treap.close();
+    unlink(ARENA_PATH);
+    free(insertions);
+    free(deletions);
+    free(searches);
+}
+
+void experiment5() {
+    TrialRunner runner(trial_settings, 5);
+    cout << "==Experiment 5==\n"
+         << "> Num. Mixed operations on file-backed arena (L) = 1000000\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment5_phase(1000000, 900000, 50000, 50000); });
+    cout << "> END L=1M\n\n";
+
+    cout << "> Num. Mixed operations on file-backed arena (L) = 5000000\n";
+    runner.run_isolated(1, [] { experiment5_phase(5000000, 4500000, 250000, 250000); });
+    cout << "> END L=5M\n\n";
+
+    cout << "> Num. Mixed operations on file-backed arena (L) = 10000000\n";
+    runner.run_isolated(2, [] { experiment5_phase(10000000, 9000000, 500000, 500000); });
+    cout << "> END L=10M\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 6
+ * ******************************************************************************************** */
+
+static volatile int search_sink;  // keeps search results observable
+
+// Time num_searches searches for random live keys
+void experiment6_search(RandomisedTreap& r_treap, const vector<int>& live_keys,
+                        const int num_searches, PerfCounters& perf, string label) {
+    vector<int> keys(num_searches);
+    for (int i = 0; i < num_searches; i++) {
+        keys[i] = live_keys[rng.rand_id((int)live_keys.size()) - 1];
+    }
+
+    int hits = 0;
+    const csc::time_point start = csc::now();  // Start timer
+    perf.start();
+    for (int i = 0; i < num_searches; i++) {
+        hits += r_treap.search(keys[i]) != NULL;
+    }
+    perf.stop();
+    const csc::time_point end = csc::now();  // Stop timer
+    search_sink = hits;
+    assert(("Searches for live keys missed", hits == num_searches));
+    print_time(start, end, label);
+    perf.print(num_searches);
+}
+
+void experiment6_phase(const int num_elements, const int num_churn, const int num_searches) {
+    // Initialise Data Structures
+    DataGenerator dg;
+    RandomisedTreap r_treap;
+    PerfCounters perf;
+    vector<int> live_keys(num_elements);
+
+    for (int i = 0; i < num_elements; i++) {
+        const element e = dg.gen_element();
+        r_treap.insert(e);
+        live_keys[i] = e.KEY;
+    }
+
+    // Churn: replace random elements so that neighbouring nodes end up far apart in memory
+    r_treap.compact();
+    for (int i = 0; i < num_churn; i++) {
+        const size_t victim = rng.rand_id((int)live_keys.size()) - 1;
+        r_treap.delet(live_keys[victim]);
+        const element e = dg.gen_element();
+        r_treap.insert(e);
+        live_keys[victim] = e.KEY;
+    }
+    cout << "After " << num_churn << " deletion/insertion pairs: fragmentation="
+         << r_treap.fragmentation() << '\n';
+    experiment6_search(r_treap, live_keys, num_searches, perf, "searches before compaction");
+
+    const int orders[] = {COMPACT_DFS, COMPACT_VEB};
+    const char* names[] = {"DFS", "vEB"};
+    for (int k = 0; k < 2; k++) {
+        const csc::time_point start = csc::now();  // Start timer
+        if (!r_treap.compact(orders[k])) {
+            exit(EXIT_FAILURE);
+        }
+        const csc::time_point end = csc::now();  // Stop timer
+        print_time(start, end, string(names[k]) + " compaction");
+        cout << "fragmentation=" << r_treap.fragmentation() << '\n';
+        experiment6_search(r_treap, live_keys, num_searches, perf,
+                           string("searches after ") + names[k] + " compaction");
+    }
+
+    const treap_shape shape = r_treap.validate();
+    assert(("Treap invalid after compaction", shape.ok()));
+    assert(("Size changed by compaction", shape.nodes == (size_t)num_elements));
+}
+
+void experiment6() {
+    TrialRunner runner(trial_settings, 6);
+    cout << "==Experiment 6==\n"
+         << "> Search latency before and after compaction, 1000000 elements\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment6_phase(1000000, 1000000, 1000000); });
+    cout << "> END N=1M\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 7
+ * ******************************************************************************************** */
+
+// Mean depth of the nodes found by searching for each key of ops, without changing the treap
+double mean_access_depth(RandomisedTreap& r_treap, const vector<packed_op>& ops) {
+    uint64_t total = 0;
+    uint64_t found = 0;
+    for (size_t i = 0; i < ops.size(); i++) {
+        const int depth = r_treap.key_depth(ops[i].ELEM.KEY);
+        if (depth != NOT_FOUND) {
+            total += depth;
+            found++;
+        }
+    }
+    return found > 0 ? (double)total / found : 0;
+}
+
+void experiment7_phase(const int num_records, const int num_searches, const double theta) {
+    workload_spec spec;
+    spec.key_dist = KEYDIST_ZIPF;
+    spec.zipf_theta = theta;
+    spec.mix = {0, 0, 100, 0, 0};
+    WorkloadGenerator wg(spec);
+    const vector<packed_op> load = wg.gen_load(num_records);
+    const vector<packed_op> ops = wg.gen_run(num_searches);
+
+    PerfCounters perf;
+    const int rates[] = {0, 1, ADAPTIVE_DEFAULT_ONE_IN, 16};
+    for (int k = 0; k < 4; k++) {
+        // Initialise Data Structures
+        RandomisedTreap r_treap;
+        r_treap.set_adaptive(rates[k]);
+        for (size_t i = 0; i < load.size(); i++) {
+            r_treap.insert(load[i].ELEM);
+        }
+        const string mode =
+            rates[k] == 0 ? string("static") : "adaptive 1/" + to_string(rates[k]);
+        cout << "RandomisedTreap (" << mode << "): mean_access_depth before="
+             << mean_access_depth(r_treap, ops);
+
+        int hits = 0;
+        const csc::time_point start = csc::now();  // Start timer
+        perf.start();
+        for (size_t i = 0; i < ops.size(); i++) {
+            hits += r_treap.search(ops[i].ELEM.KEY) != NULL;
+        }
+        perf.stop();
+        const csc::time_point end = csc::now();  // Stop timer
+        search_sink = hits;
+
+        cout << " after=" << mean_access_depth(r_treap, ops) << '\n';
+        print_time(start, end, to_string(num_searches) + " Zipf searches on RandomisedTreap (" +
+                                   mode + ")");
+        perf.print(num_searches);
+
+        const treap_shape shape = r_treap.validate();
+        assert(("Treap invalid after adaptive searches", shape.ok()));
+    }
+}
+
+void experiment7() {
+    TrialRunner runner(trial_settings, 7);
+    cout << "==Experiment 7==\n"
+         << "> Zipf searches (theta = 0.99) on 1000000 records, static vs adaptive priorities\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment7_phase(1000000, 1000000, 0.99); });
+    cout << "> END theta=0.99\n\n";
+
+    cout << "> Zipf searches (theta = 1.2) on 1000000 records, static vs adaptive priorities\n";
+    runner.run_isolated(1, [] { experiment7_phase(1000000, 1000000, 1.2); });
+    cout << "> END theta=1.2\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 8
+ * ******************************************************************************************** */
+
+#define EXPERIMENT8_MAX_LENGTH 1000  // interval lengths are uniform in [0, 1000)
+#define EXPERIMENT8_QUERY_SPAN 1000  // overlap queries cover [a, a + 1000)
+
+// Time num_queries overlap queries (every other one a stabbing query) on ds, returning the total
+// number of intervals reported
+template <class IntervalStore>
+long experiment8_queries(IntervalStore& ds, const vector<int>& points, string label) {
+    long found = 0;
+    const csc::time_point start = csc::now();  // Start timer
+    for (size_t i = 0; i < points.size(); i++) {
+        if (i % 2 == 0) {
+            found += ds.count_overlaps(points[i], points[i] + EXPERIMENT8_QUERY_SPAN - 1);
+        } else {
+            found += ds.stab(points[i]);
+        }
+    }
+    const csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, label);
+    return found;
+}
+
+void experiment8_phase(const int num_intervals, const int num_queries) {
+    // Initialise Data Structures
+    IntervalTreap i_treap;
+    IntervalArray i_array;
+
+    vector<interval> intervals(num_intervals);
+    for (int i = 0; i < num_intervals; i++) {
+        const int start = rng.rand_key();
+        intervals[i] = {i + 1, start, start + rng.rand_range(0, EXPERIMENT8_MAX_LENGTH - 1)};
+        i_treap.insert(intervals[i]);
+        i_array.insert(intervals[i]);
+    }
+    vector<int> points(num_queries);
+    for (int i = 0; i < num_queries; i++) {
+        points[i] = rng.rand_key();
+    }
+
+    cout << num_queries << " overlap and stabbing queries on " << num_intervals << " intervals\n";
+    const long found_array = experiment8_queries(i_array, points, "queries on IntervalArray");
+    const long found_treap = experiment8_queries(i_treap, points, "queries on IntervalTreap");
+    cout << "Intervals reported: " << found_treap << '\n';
+    assert(("IntervalTreap and IntervalArray disagree", found_treap == found_array));
+
+    // Delete every tenth interval and check the augmentation survived
+    for (int i = 0; i < num_intervals; i += 10) {
+        i_treap.delet(intervals[i].start, intervals[i].id);
+        i_array.delet(intervals[i].start, intervals[i].id);
+    }
+    assert(("IntervalTreap invalid after deletions", i_treap.validate()));
+    assert(("Sizes differ after deletions", i_treap.size() == i_array.size()));
+    const long after_array =
+        experiment8_queries(i_array, points, "queries on IntervalArray after deletions");
+    const long after_treap =
+        experiment8_queries(i_treap, points, "queries on IntervalTreap after deletions");
+    assert(("IntervalTreap and IntervalArray disagree after deletions",
+            after_treap == after_array));
+
+    print_footprint("IntervalTreap", i_treap.size(), i_treap.bytes_allocated(),
+                    i_treap.bytes_live());
+    print_footprint("IntervalArray", i_array.size(), i_array.bytes_allocated(),
+                    i_array.bytes_live());
+}
+
+void experiment8() {
+    TrialRunner runner(trial_settings, 8);
+    cout << "==Experiment 8==\n"
+         << "> Overlap queries vs Number of Intervals (N) = 10000\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment8_phase(10000, 1000); });
+    cout << "> END N=10K\n\n";
+
+    cout << "> Overlap queries vs Number of Intervals (N) = 100000\n";
+    runner.run_isolated(1, [] { experiment8_phase(100000, 1000); });
+    cout << "> END N=100K\n\n";
+
+    cout << "> Overlap queries vs Number of Intervals (N) = 1000000\n";
+    runner.run_isolated(2, [] { experiment8_phase(1000000, 1000); });
+    cout << "> END N=1M\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   EXPERIMENT 9
+ * ******************************************************************************************** */
+
+#define EXPERIMENT9_NUM_SEARCHES 100000
+
+// Flush the file and drop it from the page cache, so the next restart reads it from disk
+void drop_cached(const char* path) {
+    const int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return;
+    }
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+// Time searches for keys on a restarted store, returning the number found
+template <class Store>
+int experiment9_searches(Store& store, const vector<int>& keys, const string& label) {
+    int hits = 0;
+    const csc::time_point start = csc::now();  // Start timer
+    for (size_t i = 0; i < keys.size(); i++) {
+        hits += store.search(keys[i]) != NULL;
+    }
+    const csc::time_point end = csc::now();  // Stop timer
+    search_sink = hits;
+    print_time(start, end, label);
+    return hits;
+}
+
+void experiment9_phase(const int num_elements) {
+    const char* SNAPSHOT_PATH = "experiment9_snapshot.bin";
+
+    // Initialise Data Structures
+    DataGenerator dg;
+    RandomisedTreap r_treap;
+    vector<element> elems(num_elements);
+    for (int i = 0; i < num_elements; i++) {
+        elems[i] = dg.gen_element();
+        r_treap.insert(elems[i]);
+    }
+    vector<int> keys(EXPERIMENT9_NUM_SEARCHES);
+    for (int i = 0; i < EXPERIMENT9_NUM_SEARCHES; i++) {
+        keys[i] = elems[rng.rand_id(num_elements) - 1].KEY;
+    }
+
+    csc::time_point start = csc::now();  // Start timer
+    if (!r_treap.save(SNAPSHOT_PATH)) {
+        exit(EXIT_FAILURE);
+    }
+    csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, "snapshot save");
+
+    // Restart without a snapshot: insert every element again
+    start = csc::now();  // Start timer
+    RandomisedTreap rebuilt;
+    for (int i = 0; i < num_elements; i++) {
+        rebuilt.insert(elems[i]);
+    }
+    end = csc::now();  // Stop timer
+    print_time(start, end, "restart by re-insertion");
+    const int rebuilt_hits = experiment9_searches(rebuilt, keys, "searches after re-insertion");
+
+    // Restart by mapping the snapshot: searches fault in the nodes they touch
+    drop_cached(SNAPSHOT_PATH);
+    start = csc::now();  // Start timer
+    MappedTreap mapped;
+    if (!mapped.open_mapped(SNAPSHOT_PATH)) {
+        exit(EXIT_FAILURE);
+    }
+    end = csc::now();  // Stop timer
+    print_time(start, end, "restart by mapping the snapshot");
+    const int mapped_hits = experiment9_searches(mapped, keys, "searches on the mapped snapshot");
+    mapped.close();
+
+    // Restart by thawing the snapshot into a writable treap
+    drop_cached(SNAPSHOT_PATH);
+    start = csc::now();  // Start timer
+    MappedTreap snap;
+    if (!snap.open_mapped(SNAPSHOT_PATH)) {
+        exit(EXIT_FAILURE);
+    }
+    RandomisedTreap thawed;
+    thawed.thaw(snap);
+    snap.close();
+    end = csc::now();  // Stop timer
+    print_time(start, end, "restart by thawing the snapshot");
+    const int thawed_hits = experiment9_searches(thawed, keys, "searches after thawing");
+
+    assert(("Searches for saved keys missed", rebuilt_hits == EXPERIMENT9_NUM_SEARCHES));
+    assert(("Mapped snapshot disagrees with the treap", mapped_hits == rebuilt_hits));
+    assert(("Thawed treap disagrees with the treap", thawed_hits == rebuilt_hits));
+    assert(("Thawed treap invalid", thawed.validate().ok()));
+    print_footprint("Snapshot file", num_elements,
+                    sizeof(snapshot_header) + (size_t)num_elements * sizeof(snapshot_node),
+                    (size_t)num_elements * sizeof(element));
+    unlink(SNAPSHOT_PATH);
+}
+
+void experiment9() {
+    TrialRunner runner(trial_settings, 9);
+    cout << "==Experiment 9==\n"
+         << "> Restart time, snapshot vs re-insertion, 100000 elements\n";
+    cout << "Trial seed: " << runner.get_seed() << '\n';
+    runner.run_isolated(0, [] { experiment9_phase(100000); });
+    cout << "> END N=100K\n\n";
+
+    cout << "> Restart time, snapshot vs re-insertion, 1000000 elements\n";
+    runner.run_isolated(1, [] { experiment9_phase(1000000); });
+    cout << "> END N=1M\n\n";
+}
+
+/* ******************************************************************************************** *
+ *   TRACE RECORD AND REPLAY
+ * ******************************************************************************************** */
+
+// Record a mixed operation sequence, generated the same way as in experiment 4, to a trace file
+bool record_trace(const char* path, const int num_operations, const int num_insertions,
+                  const int num_deletions, const int num_searches) {
+    assert(("Expected num_insertions + num_deletions + num_searches == num_operations",
+            (num_insertions + num_deletions + num_searches) == num_operations));
+
+    DataGenerator dg;
+    TraceWriter writer;
+    if (!writer.open(path, TRACE_VARINT)) {
+        return false;
+    }
+
+    vector<packed_op> ops = dg.gen_operations(num_insertions, num_deletions, num_searches);
+    for (int i = 0; i < num_operations; i++) {
+        writer.record(ops[i]);
+    }
+    cout << "Recorded " << num_operations << " operations to " << path << '\n';
+    return writer.close();
+}
+
+// Replay the whole trace on a fresh Engine and print the time
+template <class Engine>
+static void replay_engine(TraceReader& reader, const char* name) {
+    Engine ds;
+    int hits = 0;
+    cout << reader.size() << " traced operations on " << name << "\n";
+    const csc::time_point start = csc::now();  // Start timer
+    const uint64_t applied = replay_trace(reader, ds, hits);
+    settle_engine(ds);
+    const csc::time_point end = csc::now();  // Stop timer
+    engine_sink = hits;
+    print_time(start, end, string("trace replay on ") + name);
+    assert(("Trace not fully replayed", applied == reader.size()));
+}
+
+// Replay a trace file against every engine the experiments run
+bool replay_trace_file(const char* path) {
+    TraceReader reader;
+    if (!reader.open(path)) {
+        return false;
+    }
+
+    for_each_engine([&reader](auto tag, const engine_info& info) {
+        typedef typename decltype(tag)::type Engine;
+        if ((info.flags & ENGINE_IN_EXPERIMENTS) != 0) {
+            replay_engine<Engine>(reader, info.label);
+        }
+    });
+    return true;
+}
@@ -1,20 +1,40 @@
-#ifndef EXPERIMENTS_H
-#define EXPERIMENTS_H
-
-#include <cassert>
-#include <iostream>
-#include <vector>
-#include <chrono>
-
-#include "data_structures.h"
-
-typedef chrono::system_clock csc;
-
-void print_time(csc::time_point start, csc::time_point end, string activity);
-void experiment0();
-void experiment1();
-void experiment2();
-void experiment3();
-void experiment4();
-
-#endif  // EXPERIMENTS_H
+#ifndef EXPERIMENTS_H
+#define EXPERIMENTS_H
+
+#include <cassert>
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <sstream>
+#include <type_traits>
+
+#include "arena_treap.h"
+#include "data_structures.h"
+#include "engines.h"
+#include "interval_treap.h"
+#include "lock_free_skiplist.h"
+#include "mem_stats.h"
+#include "perf_counters.h"
+#include "trace.h"
+#include "trial_runner.h"
+#include "workload_generator.h"
+
+typedef chrono::system_clock csc;
+
+void print_time(csc::time_point start, csc::time_point end, string activity);
+void configure_trials(const trial_config& config);
+void experiment0();
+void experiment1();
+void experiment2();
+void experiment3();
+void experiment4();
+void experiment5();
+void experiment6();
+void experiment7();
+void experiment8();
+void experiment9();
+bool record_trace(const char* path, const int num_operations, const int num_insertions,
+                  const int num_deletions, const int num_searches);
+bool replay_trace_file(const char* path);
+
+#endif  // EXPERIMENTS_H
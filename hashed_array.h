@@ -0,0 +1,221 @@
+#ifndef HASHED_ARRAY_H
+#define HASHED_ARRAY_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "data_structures.h"
+
+#define INDEX_EMPTY -1  // slot of an unused index entry
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   HASHED DYNAMIC ARRAY
+ *
+ *   DynamicArray with an open-addressing index from key to array slot next to the packed
+ *   elements, so search and delet are O(1) expected instead of a linear search. Elements stay
+ *   dense and unordered, and delet still swaps the last element into the hole; its index entry
+ *   is repointed to the new slot. The index is linear-probed with Fibonacci hashing and has
+ *   twice as many entries as the array has capacity (load factor at most 1/2). It is rebuilt
+ *   whenever the array is resized, and entries are removed by backward shifting, so there are
+ *   no tombstones. Duplicate keys each have their own entry.
+ * ******************************************************************************************** */
+
+struct index_entry {
+    int key;
+    int slot;  // INDEX_EMPTY => unused
+};
+
+class HashedDynamicArray {
+   private:
+    int count = 0;
+    int capacity = 1;
+    element* list;
+    index_entry* index;
+    size_t index_mask;  // index has index_mask + 1 entries, a power of two
+    int shift;          // 32 - log2(index entries)
+
+    size_t home(const int key) { return fib_hash(key, shift); }
+
+    // Index position of the entry for slot (which holds key)
+    size_t find_entry(const int key, const int slot) {
+        size_t i = home(key);
+        while (index[i].slot != slot) {
+            i = (i + 1) & index_mask;
+        }
+        return i;
+    }
+
+    void add_entry(const int key, const int slot) {
+        size_t i = home(key);
+        while (index[i].slot != INDEX_EMPTY) {
+            i = (i + 1) & index_mask;
+        }
+        index[i].key = key;
+        index[i].slot = slot;
+    }
+
+    // Backward-shift deletion: pull later entries of the probe run into the hole, so every
+    // remaining entry is still reachable from its home position
+    void remove_entry(size_t hole) {
+        size_t i = hole;
+        while (true) {
+            i = (i + 1) & index_mask;
+            if (index[i].slot == INDEX_EMPTY) {
+                break;
+            }
+            const size_t h = home(index[i].key);
+            // Move entry i unless its home lies cyclically in (hole, i]
+            if (((i - h) & index_mask) >= ((i - hole) & index_mask)) {
+                index[hole] = index[i];
+                hole = i;
+            }
+        }
+        index[hole].slot = INDEX_EMPTY;
+    }
+
+    void grow() {
+        capacity *= 2;
+        resize();
+    }
+
+    void shrink() {
+        capacity /= 2;
+        resize();
+    }
+
+    void resize() {
+        element* new_list = (element*)realloc(list, capacity * sizeof(element));
+        if (new_list == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        list = new_list;
+        rebuild_index();
+    }
+
+    // Size the index to twice the array capacity and re-add every element
+    void rebuild_index() {
+        int log_entries = 1;
+        while ((1 << log_entries) < 2 * capacity) {
+            log_entries++;
+        }
+        free(index);
+        index = (index_entry*)malloc(((size_t)1 << log_entries) * sizeof(index_entry));
+        if (index == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        index_mask = ((size_t)1 << log_entries) - 1;
+        shift = 32 - log_entries;
+        for (size_t i = 0; i <= index_mask; i++) {
+            index[i].slot = INDEX_EMPTY;
+        }
+        for (int i = 0; i < count; i++) {
+            add_entry(list[i].KEY, i);
+        }
+    }
+
+   public:
+    HashedDynamicArray() : index(NULL) {
+        list = (element*)malloc(1 * sizeof(element));
+        if (list == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        rebuild_index();
+    }
+    ~HashedDynamicArray() {
+        free(list);
+        free(index);
+    }
+
+    HashedDynamicArray(const HashedDynamicArray&) = delete;
+    HashedDynamicArray& operator=(const HashedDynamicArray&) = delete;
+
+    void insert(element x) {
+        if (count + 1 == capacity) {
+            grow();
+        }
+        list[count] = x;
+        add_entry(x.KEY, count);
+        count++;
+    }
+
+    void delet(int key) {
+        size_t i = home(key);
+        while (index[i].slot != INDEX_EMPTY && index[i].key != key) {
+            i = (i + 1) & index_mask;
+        }
+        if (index[i].slot == INDEX_EMPTY) {
+            return;
+        }
+        const int pos = index[i].slot;
+        remove_entry(i);
+
+        // move last elem into the hole, decrease count
+        count -= 1;
+        if (pos != count) {
+            index[find_entry(list[count].KEY, count)].slot = pos;
+            list[pos] = list[count];
+        }
+
+        if (count < (capacity / 4)) {
+            shrink();
+        }
+    }
+
+    // Slot of an element with key, or NOT_FOUND
+    int search(int key) {
+        size_t i = home(key);
+        while (index[i].slot != INDEX_EMPTY) {
+            if (index[i].key == key) {
+                return index[i].slot;
+            }
+            i = (i + 1) & index_mask;
+        }
+        return NOT_FOUND;
+    }
+
+    // Range scan is a full pass: the list is unordered
+    int range_scan(int lo, int hi) {
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            found += (lo <= list[i].KEY && list[i].KEY <= hi);
+        }
+        return found;
+    }
+
+    size_t size() { return count; }
+
+    size_t bytes_allocated() {
+        return capacity * sizeof(element) + (index_mask + 1) * sizeof(index_entry);
+    }
+
+    size_t bytes_live() { return count * sizeof(element); }
+
+    // Every element has exactly one index entry, reachable from its home position
+    bool validate() {
+        size_t entries = 0;
+        for (size_t i = 0; i <= index_mask; i++) {
+            if (index[i].slot == INDEX_EMPTY) {
+                continue;
+            }
+            entries++;
+            const int slot = index[i].slot;
+            if (slot < 0 || slot >= count || list[slot].KEY != index[i].key) {
+                return false;
+            }
+            for (size_t j = home(index[i].key); j != i; j = (j + 1) & index_mask) {
+                if (index[j].slot == INDEX_EMPTY) {
+                    return false;
+                }
+            }
+        }
+        return entries == (size_t)count;
+    }
+};
+
+#endif  // HASHED_ARRAY_H
@@ -0,0 +1,112 @@
+#ifndef HOT_KEY_CACHE_H
+#define HOT_KEY_CACHE_H
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "rand_int_generator.h"
+
+#define HOT_CACHE_WAYS 2
+#define HOT_CACHE_DEFAULT_SETS 512  // 512 sets x 2 ways = 1024 keys in 16KB, half of a typical L1d
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   HOT-KEY LOOKUP CACHE
+ *
+ *   Small 2-way set-associative map from key to node, consulted before a search descends from
+ *   the root. A set (two keys, two node pointers and the most recently used way) fits in half
+ *   a cache line and sets are cache-line aligned in pairs, so a lookup touches one line. Keys
+ *   are spread over sets by Fibonacci hashing. Only hits are cached: the owner must invalidate
+ *   a key when a node with that key is freed and clear() when nodes move.
+ * ******************************************************************************************** */
+
+struct hot_cache_stats {
+    uint64_t hits;
+    uint64_t misses;
+};
+
+template <class Node>
+class HotKeyCache {
+   private:
+    struct alignas(32) cache_set {
+        int keys[HOT_CACHE_WAYS];
+        Node* nodes[HOT_CACHE_WAYS];  // NULL => empty way
+        int mru;                      // way used most recently
+    };
+
+    cache_set* sets;
+    size_t num_sets;
+    int shift;  // 32 - log2(number of sets)
+    hot_cache_stats stats;
+
+    cache_set& set_for(const int key) { return sets[fib_hash(key, shift)]; }
+
+   public:
+    // min_sets is rounded up to a power of two, and to at least 2
+    explicit HotKeyCache(const int min_sets = HOT_CACHE_DEFAULT_SETS) {
+        int log_sets = 1;
+        while ((1 << log_sets) < min_sets) {
+            log_sets++;
+        }
+        num_sets = (size_t)1 << log_sets;
+        shift = 32 - log_sets;
+        sets = (cache_set*)aligned_alloc(64, num_sets * sizeof(cache_set));
+        if (sets == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        clear();
+        memset(&stats, 0, sizeof(stats));
+    }
+    ~HotKeyCache() { free(sets); }
+
+    HotKeyCache(const HotKeyCache&) = delete;
+    HotKeyCache& operator=(const HotKeyCache&) = delete;
+
+    // Node cached for key, or NULL. Counts a hit or a miss.
+    Node* lookup(const int key) {
+        cache_set& s = set_for(key);
+        for (int w = 0; w < HOT_CACHE_WAYS; w++) {
+            if (s.nodes[w] != NULL && s.keys[w] == key) {
+                s.mru = w;
+                stats.hits++;
+                return s.nodes[w];
+            }
+        }
+        stats.misses++;
+        return NULL;
+    }
+
+    // Cache node under key, evicting the least recently used way of its set (with two ways,
+    // the one that is not the most recently used)
+    void store(const int key, Node* node) {
+        cache_set& s = set_for(key);
+        const int victim = 1 - s.mru;
+        s.keys[victim] = key;
+        s.nodes[victim] = node;
+        s.mru = victim;
+    }
+
+    // Drop key from the cache (its node may be about to be freed)
+    void invalidate(const int key) {
+        cache_set& s = set_for(key);
+        for (int w = 0; w < HOT_CACHE_WAYS; w++) {
+            if (s.keys[w] == key) {
+                s.nodes[w] = NULL;
+            }
+        }
+    }
+
+    void clear() { memset(sets, 0, num_sets * sizeof(cache_set)); }
+
+    hot_cache_stats get_stats() { return stats; }
+
+    void reset_stats() { memset(&stats, 0, sizeof(stats)); }
+
+    size_t bytes_allocated() { return num_sets * sizeof(cache_set); }
+};
+
+#endif  // HOT_KEY_CACHE_H
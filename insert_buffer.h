@@ -0,0 +1,151 @@
+#ifndef INSERT_BUFFER_H
+#define INSERT_BUFFER_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define HAVE_SSE2 1
+#else
+#define HAVE_SSE2 0
+#endif
+
+#include "rand_int_generator.h"
+
+#define INSERT_BUFFER_DEFAULT_CAPACITY 4096  // 16KB of keys, half of a typical L1d
+#define BUFFER_MISS -1  // InsertBuffer::find() found no element with the key
+#define BUFFER_FILTER_BITS_PER_KEY 16  // ~6% of lookups for absent keys still scan the buffer
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   INSERT BUFFER
+ *
+ *   Unordered append buffer of recent insertions, drained into a treap in sorted batches. Keys
+ *   are kept apart from the elements so a lookup compares four keys per SSE2 instruction (a
+ *   scalar loop where SSE2 is not available). Removing an element moves the last one into its
+ *   slot, so the buffer stays dense and every slot up to size() holds a live element.
+ *   Most lookups are for keys that are not buffered, so a one-hash bit filter over the buffered
+ *   keys answers those without a scan. Bits are only cleared when the buffer is drained, so a
+ *   removed key can still cost a scan until then.
+ * ******************************************************************************************** */
+
+class InsertBuffer {
+   private:
+    int* keys;
+    element* elems;
+    int count;
+    int capacity;
+    uint64_t* filter;  // bit set => some buffered key may hash to it
+    int filter_shift;  // 32 - log2(filter bits)
+
+    size_t filter_bit(const int key) { return fib_hash(key, filter_shift); }
+
+    size_t filter_words() { return ((size_t)1 << (32 - filter_shift)) / 64; }
+
+   public:
+    explicit InsertBuffer(const int capacity = INSERT_BUFFER_DEFAULT_CAPACITY)
+        : count(0), capacity(max(capacity, 1)) {
+        keys = (int*)malloc(this->capacity * sizeof(int));
+        elems = (element*)malloc(this->capacity * sizeof(element));
+        int log_bits = 6;
+        while ((1 << log_bits) < this->capacity * BUFFER_FILTER_BITS_PER_KEY && log_bits < 30) {
+            log_bits++;
+        }
+        filter_shift = 32 - log_bits;
+        filter = (uint64_t*)calloc(filter_words(), sizeof(uint64_t));
+        if (keys == NULL || elems == NULL || filter == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~InsertBuffer() {
+        free(keys);
+        free(elems);
+        free(filter);
+    }
+
+    InsertBuffer(const InsertBuffer&) = delete;
+    InsertBuffer& operator=(const InsertBuffer&) = delete;
+
+    // Append e. The caller drains the buffer once full() (appending to a full buffer aborts).
+    void append(const element e) {
+        if (count == capacity) {
+            cerr << "Insert buffer overflow, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        keys[count] = e.KEY;
+        elems[count] = e;
+        count++;
+        const size_t bit = filter_bit(e.KEY);
+        filter[bit / 64] |= (uint64_t)1 << (bit % 64);
+    }
+
+    // Slot of an element with key, or BUFFER_MISS
+    int find(const int key) {
+        const size_t bit = filter_bit(key);
+        if ((filter[bit / 64] & ((uint64_t)1 << (bit % 64))) == 0) {
+            return BUFFER_MISS;
+        }
+        int i = 0;
+#if HAVE_SSE2
+        const __m128i needle = _mm_set1_epi32(key);
+        // 16 keys per test; the 4-key loop below finds the match within the block
+        for (; i + 16 <= count; i += 16) {
+            const __m128i* block = (const __m128i*)(keys + i);
+            const __m128i hits =
+                _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi32(_mm_loadu_si128(block), needle),
+                                          _mm_cmpeq_epi32(_mm_loadu_si128(block + 1), needle)),
+                             _mm_or_si128(_mm_cmpeq_epi32(_mm_loadu_si128(block + 2), needle),
+                                          _mm_cmpeq_epi32(_mm_loadu_si128(block + 3), needle)));
+            if (_mm_movemask_epi8(hits) != 0) {
+                break;
+            }
+        }
+        for (; i + 4 <= count; i += 4) {
+            const __m128i block = _mm_loadu_si128((const __m128i*)(keys + i));
+            const int mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(block, needle)));
+            if (mask != 0) {
+                return i + __builtin_ctz(mask);
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            if (keys[i] == key) {
+                return i;
+            }
+        }
+        return BUFFER_MISS;
+    }
+
+    element* at(const int slot) { return &elems[slot]; }
+
+    // Remove the element in slot, moving the last element into it
+    void remove(const int slot) {
+        count--;
+        keys[slot] = keys[count];
+        elems[slot] = elems[count];
+    }
+
+    // Buffered elements, in insertion order up to removals
+    element* data() { return elems; }
+
+    void clear() {
+        count = 0;
+        memset(filter, 0, filter_words() * sizeof(uint64_t));
+    }
+
+    bool full() { return count == capacity; }
+
+    size_t size() { return count; }
+
+    size_t bytes_allocated() {
+        return capacity * (sizeof(int) + sizeof(element)) + filter_words() * sizeof(uint64_t);
+    }
+};
+
+#endif  // INSERT_BUFFER_H
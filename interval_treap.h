@@ -0,0 +1,226 @@
+#ifndef INTERVAL_TREAP_H
+#define INTERVAL_TREAP_H
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+#include "rand_int_generator.h"
+#include "treap_ops.h"
+
+using namespace std;
+
+// A closed interval [start, end] with a caller-chosen id
+struct interval {
+    int id;
+    int start;
+    int end;
+};
+
+/* ******************************************************************************************** *
+ *   INTERVAL TREAP
+ *
+ *   RandomisedTreap keyed on interval start, with every node also storing the largest end in
+ *   its subtree. A subtree whose max_end is below the query start cannot overlap it, and nodes
+ *   right of one whose start is past the query end cannot either, so an overlap query visits
+ *   O(log n + k) nodes in expectation for k results. The treap operations are the shared ones
+ *   in treap_ops.h; its treap_update() hook recomputes max_end bottom-up after every rotation,
+ *   insertion and deletion.
+ * ******************************************************************************************** */
+
+struct interval_node {
+    interval iv;
+    int priority;
+    int max_end;  // largest end in this subtree
+    interval_node* left;
+    interval_node* right;
+
+    interval_node(interval iv, int p)
+        : iv(iv), priority(p), max_end(iv.end), left(NULL), right(NULL) {}
+
+    int get_key() { return iv.start; }
+};
+
+static inline int max_end_of(const interval_node* node) {
+    return node != NULL ? node->max_end : INT_MIN;
+}
+
+// treap_ops.h hooks: keep max_end up to date, and check it in validate()
+static inline void treap_update(interval_node* node) {
+    node->max_end = max(node->iv.end, max(max_end_of(node->left), max_end_of(node->right)));
+}
+
+static inline bool treap_node_valid(interval_node* node) {
+    return node->max_end ==
+           max(node->iv.end, max(max_end_of(node->left), max_end_of(node->right)));
+}
+
+class IntervalTreap {
+   private:
+    interval_node* head;
+    size_t num_nodes;
+
+    // Core helper function for deletion operation: find the interval with this start and id.
+    // Equal starts can sit on either side of a node after rotations, so both are searched.
+    interval_node* delete_search(interval_node* head, const int start, const int id,
+                                 bool& deleted) {
+        if (head == NULL) {
+            return NULL;
+        }
+        if (start == head->iv.start && id == head->iv.id) {
+            deleted = true;
+            return treap_delete_root(head, [this](interval_node* node) {
+                delete (node);
+                num_nodes--;
+            });
+        }
+        if (start <= head->iv.start) {
+            head->left = delete_search(head->left, start, id, deleted);
+        }
+        if (!deleted && head->iv.start <= start) {
+            head->right = delete_search(head->right, start, id, deleted);
+        }
+        if (deleted) {
+            treap_update(head);
+        }
+        return head;
+    }
+
+    // Core helper function for overlap queries
+    template <class Visitor>
+    void overlaps_node(interval_node* head, const int a, const int b, Visitor& visit) {
+        if (head == NULL || head->max_end < a) {  // nothing below reaches a
+            return;
+        }
+        overlaps_node(head->left, a, b, visit);
+        if (head->iv.start > b) {  // this and everything to the right start after b
+            return;
+        }
+        if (a <= head->iv.end) {
+            visit(head->iv);
+        }
+        overlaps_node(head->right, a, b, visit);
+    }
+
+   public:
+    IntervalTreap() : head(NULL), num_nodes(0) {}
+    ~IntervalTreap() { treap_dealloc(head); }
+
+    IntervalTreap(const IntervalTreap&) = delete;
+    IntervalTreap& operator=(const IntervalTreap&) = delete;
+
+    // Perform insertion operation
+    void insert(const interval iv) {
+        interval_node* n = new interval_node(iv, rng.rand_priority());
+        num_nodes++;
+        head = treap_insert(head, n);
+    }
+
+    // Perform deletion operation: remove the interval with this start and id, if present
+    bool delet(const int start, const int id) {
+        bool deleted = false;
+        head = delete_search(head, start, id, deleted);
+        return deleted;
+    }
+
+    // Call visit(const interval&) for every interval overlapping [a, b], in start order
+    template <class Visitor>
+    void overlaps(const int a, const int b, Visitor visit) {
+        overlaps_node(head, a, b, visit);
+    }
+
+    // Number of intervals overlapping [a, b]
+    int count_overlaps(const int a, const int b) {
+        int count = 0;
+        overlaps(a, b, [&count](const interval&) { count++; });
+        return count;
+    }
+
+    // Number of intervals containing point
+    int stab(const int point) { return count_overlaps(point, point); }
+
+    size_t size() { return num_nodes; }
+
+    size_t bytes_allocated() { return num_nodes * sizeof(interval_node); }
+
+    size_t bytes_live() { return num_nodes * sizeof(interval); }
+
+    // BST order on start, heap order on priority, every max_end and the node count
+    bool validate() {
+        size_t count = 0;
+        return treap_valid(head, INT_MIN, INT_MAX, count) && count == num_nodes;
+    }
+};
+
+/* ******************************************************************************************** *
+ *   INTERVAL ARRAY
+ *
+ *   Baseline for IntervalTreap: unordered intervals in a growable array, like DynamicArray.
+ *   Every query is a full pass.
+ * ******************************************************************************************** */
+
+class IntervalArray {
+   private:
+    int count = 0;
+    int capacity = 1;
+    interval* list;
+
+    void grow() {
+        capacity *= 2;
+        interval* new_list = (interval*)realloc(list, capacity * sizeof(interval));
+        if (new_list == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        list = new_list;
+    }
+
+   public:
+    IntervalArray() {
+        list = (interval*)malloc(1 * sizeof(interval));
+        if (list == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~IntervalArray() { free(list); }
+
+    IntervalArray(const IntervalArray&) = delete;
+    IntervalArray& operator=(const IntervalArray&) = delete;
+
+    void insert(const interval iv) {
+        if (count == capacity) {
+            grow();
+        }
+        list[count++] = iv;
+    }
+
+    // Remove the interval with this start and id, if present (swap with the last one)
+    bool delet(const int start, const int id) {
+        for (int i = 0; i < count; i++) {
+            if (list[i].start == start && list[i].id == id) {
+                list[i] = list[--count];
+                return true;
+            }
+        }
+        return false;
+    }
+
+    int count_overlaps(const int a, const int b) {
+        int found = 0;
+        for (int i = 0; i < count; i++) {
+            found += (list[i].start <= b && a <= list[i].end);
+        }
+        return found;
+    }
+
+    int stab(const int point) { return count_overlaps(point, point); }
+
+    size_t size() { return count; }
+
+    size_t bytes_allocated() { return capacity * sizeof(interval); }
+
+    size_t bytes_live() { return count * sizeof(interval); }
+};
+
+#endif  // INTERVAL_TREAP_H
@@ -0,0 +1,119 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstdint>
+#include <cstring>
+
+#include "rand_int_generator.h"
+#include "timing.h"
+
+// Each power of two is split into 2^LATENCY_SUB_BITS linear sub-buckets (~3% precision)
+#define LATENCY_SUB_BITS 5
+#define LATENCY_SUB_COUNT (1 << LATENCY_SUB_BITS)
+#define LATENCY_NUM_BUCKETS ((64 - LATENCY_SUB_BITS + 1) * LATENCY_SUB_COUNT)
+
+// Record every LATENCY_SAMPLE_RATE-th operation (must be a power of two; 1 = every operation)
+#ifndef LATENCY_SAMPLE_RATE
+#define LATENCY_SAMPLE_RATE 1
+#endif
+
+/* Per-operation latency recording is compiled in only with -DLATENCY_HISTOGRAMS (make LATENCY=1).
+ * Otherwise both macros expand to nothing and the timed loops are unchanged. */
+#ifdef LATENCY_HISTOGRAMS
+#define LATENCY_BEGIN(i)                                                       \
+    const bool latency_sampled = (((i) & (LATENCY_SAMPLE_RATE - 1)) == 0); \
+    const uint64_t latency_start = latency_sampled ? read_tsc() : 0
+#define LATENCY_END(hist)                                \
+    if (latency_sampled) {                               \
+        (hist).record(read_tsc() - latency_start);       \
+    }
+#else
+#define LATENCY_BEGIN(i)
+#define LATENCY_END(hist)
+#endif
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   LOG-BUCKETED (HDR-STYLE) LATENCY HISTOGRAM
+ *
+ *   Values below LATENCY_SUB_COUNT get a bucket each. Above that, a value with its highest set
+ *   bit at position e lands in one of LATENCY_SUB_COUNT equal-width buckets covering
+ *   [2^e, 2^(e+1)), so relative error is bounded at every magnitude with a fixed-size table.
+ * ******************************************************************************************** */
+
+class LatencyHistogram {
+   private:
+    uint64_t counts[LATENCY_NUM_BUCKETS];
+    uint64_t total;
+    uint64_t max_value;
+
+    static int bucket_of(const uint64_t v) {
+        if (v < LATENCY_SUB_COUNT) {
+            return (int)v;
+        }
+        const int shift = (63 - __builtin_clzll(v)) - LATENCY_SUB_BITS;
+        return (shift + 1) * LATENCY_SUB_COUNT + (int)((v >> shift) - LATENCY_SUB_COUNT);
+    }
+
+    // Largest value that maps to bucket b
+    static uint64_t highest_in_bucket(const int b) {
+        if (b < 2 * LATENCY_SUB_COUNT) {
+            return b;
+        }
+        const int shift = b / LATENCY_SUB_COUNT - 1;
+        const uint64_t sub = b % LATENCY_SUB_COUNT + LATENCY_SUB_COUNT;
+        return (sub << shift) + ((uint64_t)1 << shift) - 1;
+    }
+
+   public:
+    LatencyHistogram() { reset(); }
+
+    void reset() {
+        memset(counts, 0, sizeof(counts));
+        total = 0;
+        max_value = 0;
+    }
+
+    void record(const uint64_t v) {
+        counts[bucket_of(v)]++;
+        total++;
+        max_value = max(max_value, v);
+    }
+
+    void merge(const LatencyHistogram& other) {
+        for (int b = 0; b < LATENCY_NUM_BUCKETS; b++) {
+            counts[b] += other.counts[b];
+        }
+        total += other.total;
+        max_value = max(max_value, other.max_value);
+    }
+
+    uint64_t count() const { return total; }
+
+    uint64_t max_recorded() const { return max_value; }
+
+    // Smallest recorded value v such that at least p percent of samples are <= v
+    uint64_t percentile(const double p) const {
+        if (total == 0) {
+            return 0;
+        }
+        uint64_t rank = (uint64_t)(p / 100 * total + 0.5);
+        rank = max(rank, (uint64_t)1);
+        uint64_t seen = 0;
+        for (int b = 0; b < LATENCY_NUM_BUCKETS; b++) {
+            seen += counts[b];
+            if (seen >= rank) {
+                return min(highest_in_bucket(b), max_value);
+            }
+        }
+        return max_value;
+    }
+};
+
+// One histogram per operation type, indexed by OPTYPE_*
+struct op_latencies {
+    LatencyHistogram by_type[OPTYPE_MAX + 1];
+};
+
+#endif  // LATENCY_HISTOGRAM_H
@@ -0,0 +1,320 @@
+#ifndef LOCK_FREE_SKIPLIST_H
+#define LOCK_FREE_SKIPLIST_H
+
+#include <atomic>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+#include "epoch_reclaim.h"
+#include "rand_int_generator.h"
+
+#define SKIPLIST_MAX_LEVEL 24  // enough for 2^24 elements at p = 1/2
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   LOCK-FREE SKIP LIST
+ *
+ *   Fraser-style concurrent skip list: insert, delet, search and range_scan may be called from
+ *   any number of threads at once, and none of them takes a lock.
+ *   - Nodes are ordered by (key, node address), so duplicate keys are allowed, as in the treap,
+ *     and every node still has a unique position to link and unlink.
+ *   - Deletion is logical first: the low bit of each of the node's next pointers is set (top
+ *     level down), and whoever marks level 0 owns the deletion. Marked nodes are then unlinked
+ *     by that thread's search, or by any other traversal that meets them.
+ *   - An insertion whose node is deleted while it is still linking the upper levels stops, and
+ *     unlinks whatever it linked. The node is retired to the EpochDomain only after both the
+ *     inserter and the deleter are done with it, so it is never freed while still linked.
+ * ******************************************************************************************** */
+
+struct skip_node {
+    element elem;
+    int height;
+    atomic<int> owners;           // inserter + deleter still to finish with the node
+    atomic<uintptr_t> next[1];    // `height` links, low bit set => node deleted at that level
+
+    int get_key() const { return elem.KEY; }
+};
+
+class LockFreeSkipList {
+   private:
+    skip_node* head;  // sentinel before every node
+    skip_node* tail;  // sentinel after every node
+    atomic<long> num_nodes;
+
+    static bool is_marked(const uintptr_t link) { return (link & 1) != 0; }
+
+    static skip_node* to_node(const uintptr_t link) { return (skip_node*)(link & ~(uintptr_t)1); }
+
+    static skip_node* alloc_node(const element e, const int height) {
+        void* mem = malloc(sizeof(skip_node) + (height - 1) * sizeof(atomic<uintptr_t>));
+        if (mem == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        skip_node* node = (skip_node*)mem;
+        node->elem = e;
+        node->height = height;
+        new (&node->owners) atomic<int>(2);
+        for (int l = 0; l < height; l++) {
+            new (&node->next[l]) atomic<uintptr_t>(0);
+        }
+        return node;
+    }
+
+    static void free_node(void* node) { free(node); }
+
+    // Geometric height with p = 1/2
+    static int random_height() {
+        const unsigned bits = (unsigned)rng.rand_priority() | (1u << (SKIPLIST_MAX_LEVEL - 1));
+        return __builtin_ctz(bits) + 1;
+    }
+
+    // (key, tiebreak) order; the tail sorts after everything
+    bool before(const skip_node* node, const int key, const uintptr_t tiebreak) const {
+        if (node == tail) {
+            return false;
+        }
+        return node->get_key() < key || (node->get_key() == key && (uintptr_t)node < tiebreak);
+    }
+
+    /* Fill preds/succs with, at every level, the last node before (key, tiebreak) and the one
+     * after it, unlinking marked nodes on the way. Restarts if an unlink loses a race.
+     * tiebreak 0 finds the first node with this key; a node's address finds that node. */
+    void find(const int key, const uintptr_t tiebreak, skip_node** preds, skip_node** succs) {
+    retry:
+        skip_node* pred = head;
+        for (int l = SKIPLIST_MAX_LEVEL - 1; l >= 0; l--) {
+            skip_node* curr = to_node(pred->next[l].load(memory_order_acquire));
+            while (true) {
+                if (curr != tail) {
+                    uintptr_t succ = curr->next[l].load(memory_order_acquire);
+                    while (is_marked(succ)) {  // curr is deleted: unlink it at this level
+                        uintptr_t expected = (uintptr_t)curr;
+                        if (!pred->next[l].compare_exchange_strong(expected, succ & ~(uintptr_t)1,
+                                                                   memory_order_acq_rel)) {
+                            goto retry;
+                        }
+                        curr = to_node(succ);
+                        if (curr == tail) {
+                            break;
+                        }
+                        succ = curr->next[l].load(memory_order_acquire);
+                    }
+                }
+                if (!before(curr, key, tiebreak)) {
+                    break;
+                }
+                pred = curr;
+                curr = to_node(curr->next[l].load(memory_order_acquire));
+            }
+            preds[l] = pred;
+            succs[l] = curr;
+        }
+    }
+
+    // The inserter or the deleter is done with node; the last one retires it
+    void release(skip_node* node, EpochGuard& guard) {
+        if (node->owners.fetch_sub(1, memory_order_acq_rel) == 1) {
+            guard.retire(node, free_node);
+        }
+    }
+
+   public:
+    LockFreeSkipList() : num_nodes(0) {
+        const element none = {0, 0};
+        head = alloc_node(none, SKIPLIST_MAX_LEVEL);
+        tail = alloc_node(none, SKIPLIST_MAX_LEVEL);
+        for (int l = 0; l < SKIPLIST_MAX_LEVEL; l++) {
+            head->next[l].store((uintptr_t)tail);
+        }
+    }
+
+    // Not thread-safe: every other thread must be done with the list
+    ~LockFreeSkipList() {
+        skip_node* node = to_node(head->next[0].load());
+        while (node != tail) {
+            skip_node* next = to_node(node->next[0].load());
+            if (!is_marked(node->next[0].load())) {  // marked nodes belong to the epoch domain
+                free(node);
+            }
+            node = next;
+        }
+        free(head);
+        free(tail);
+    }
+
+    LockFreeSkipList(const LockFreeSkipList&) = delete;
+    LockFreeSkipList& operator=(const LockFreeSkipList&) = delete;
+
+    // Perform insertion operation
+    void insert(element e) {
+        EpochGuard guard;
+        skip_node* preds[SKIPLIST_MAX_LEVEL];
+        skip_node* succs[SKIPLIST_MAX_LEVEL];
+        const int height = random_height();
+        skip_node* node = alloc_node(e, height);
+        const uintptr_t self = (uintptr_t)node;
+
+        // Linking level 0 makes the node visible
+        while (true) {
+            find(e.KEY, self, preds, succs);
+            for (int l = 0; l < height; l++) {
+                node->next[l].store((uintptr_t)succs[l], memory_order_relaxed);
+            }
+            uintptr_t expected = (uintptr_t)succs[0];
+            if (preds[0]->next[0].compare_exchange_strong(expected, self, memory_order_acq_rel)) {
+                break;
+            }
+        }
+        num_nodes.fetch_add(1, memory_order_relaxed);
+
+        // Link the upper levels, unless a deleter gets there first
+        for (int l = 1; l < height; l++) {
+            bool linked = false;
+            while (!linked) {
+                uintptr_t link = node->next[l].load(memory_order_acquire);
+                if (is_marked(link)) {
+                    break;
+                }
+                if (to_node(link) != succs[l] &&
+                    !node->next[l].compare_exchange_strong(link, (uintptr_t)succs[l],
+                                                           memory_order_acq_rel)) {
+                    continue;  // marked meanwhile: checked at the top
+                }
+                uintptr_t expected = (uintptr_t)succs[l];
+                linked = preds[l]->next[l].compare_exchange_strong(expected, self,
+                                                                   memory_order_acq_rel);
+                if (!linked) {
+                    find(e.KEY, self, preds, succs);
+                }
+            }
+            if (!linked) {
+                break;
+            }
+        }
+        if (is_marked(node->next[0].load(memory_order_acquire))) {
+            find(e.KEY, self, preds, succs);  // deleted while linking: unlink what we linked
+        }
+        release(node, guard);
+    }
+
+    // Perform deletion operation: remove one node with this key, if there is one
+    void delet(const int key) {
+        EpochGuard guard;
+        skip_node* preds[SKIPLIST_MAX_LEVEL];
+        skip_node* succs[SKIPLIST_MAX_LEVEL];
+        while (true) {
+            find(key, 0, preds, succs);
+            skip_node* victim = succs[0];
+            if (victim == tail || victim->get_key() != key) {
+                return;
+            }
+            for (int l = victim->height - 1; l >= 1; l--) {
+                uintptr_t link = victim->next[l].load(memory_order_acquire);
+                while (!is_marked(link) &&
+                       !victim->next[l].compare_exchange_weak(link, link | 1,
+                                                              memory_order_acq_rel)) {
+                }
+            }
+            uintptr_t link = victim->next[0].load(memory_order_acquire);
+            while (!is_marked(link)) {
+                if (victim->next[0].compare_exchange_strong(link, link | 1,
+                                                            memory_order_acq_rel)) {
+                    // This thread owns the deletion
+                    num_nodes.fetch_sub(1, memory_order_relaxed);
+                    find(key, (uintptr_t)victim, preds, succs);
+                    release(victim, guard);
+                    return;
+                }
+            }
+            // Another thread deleted victim first: look for another node with the key
+        }
+    }
+
+    // Perform search operation
+    bool search(const int key) {
+        EpochGuard guard;
+        skip_node* pred = head;
+        skip_node* curr = NULL;
+        for (int l = SKIPLIST_MAX_LEVEL - 1; l >= 0; l--) {
+            curr = to_node(pred->next[l].load(memory_order_acquire));
+            while (before(curr, key, 0)) {
+                pred = curr;
+                curr = to_node(curr->next[l].load(memory_order_acquire));
+            }
+        }
+        // Skip nodes with the key that are being deleted
+        while (curr != tail && curr->get_key() == key) {
+            if (!is_marked(curr->next[0].load(memory_order_acquire))) {
+                return true;
+            }
+            curr = to_node(curr->next[0].load(memory_order_acquire));
+        }
+        return false;
+    }
+
+    // Perform range scan: number of elements with lo <= key <= hi
+    int range_scan(const int lo, const int hi) {
+        EpochGuard guard;
+        skip_node* pred = head;
+        skip_node* curr = NULL;
+        for (int l = SKIPLIST_MAX_LEVEL - 1; l >= 0; l--) {
+            curr = to_node(pred->next[l].load(memory_order_acquire));
+            while (before(curr, lo, 0)) {
+                pred = curr;
+                curr = to_node(curr->next[l].load(memory_order_acquire));
+            }
+        }
+        int count = 0;
+        while (curr != tail && curr->get_key() <= hi) {
+            const uintptr_t link = curr->next[0].load(memory_order_acquire);
+            count += !is_marked(link);
+            curr = to_node(link);
+        }
+        return count;
+    }
+
+    // Approximate while other threads are updating the list
+    size_t size() { return (size_t)num_nodes.load(memory_order_relaxed); }
+
+    // Bytes requested for the elements' nodes, at the average height of 2 links (excludes
+    // per-allocation malloc overhead)
+    size_t bytes_allocated() {
+        return size() * (sizeof(skip_node) + sizeof(atomic<uintptr_t>));
+    }
+
+    size_t bytes_live() { return size() * sizeof(element); }
+
+    // Level 0 is sorted by key, every level is a sublist of the one below, and the unmarked
+    // nodes at level 0 add up to size(). Not thread-safe.
+    bool validate() {
+        size_t count = 0;
+        for (skip_node* node = to_node(head->next[0].load()); node != tail;
+             node = to_node(node->next[0].load())) {
+            count += !is_marked(node->next[0].load());
+            skip_node* next = to_node(node->next[0].load());
+            if (next != tail && next->get_key() < node->get_key()) {
+                return false;
+            }
+        }
+        for (int l = 1; l < SKIPLIST_MAX_LEVEL; l++) {
+            skip_node* below = to_node(head->next[l - 1].load());
+            for (skip_node* node = to_node(head->next[l].load()); node != tail;
+                 node = to_node(node->next[l].load())) {
+                while (below != tail && below != node) {
+                    below = to_node(below->next[l - 1].load());
+                }
+                if (below == tail) {
+                    return false;
+                }
+            }
+        }
+        return count == size();
+    }
+};
+
+#endif  // LOCK_FREE_SKIPLIST_H
@@ -0,0 +1,99 @@
+#ifndef MEM_STATS_H
+#define MEM_STATS_H
+
+#include <malloc.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#define HAVE_MALLINFO2 1
+#else
+#define HAVE_MALLINFO2 0
+#endif
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   PROCESS MEMORY ACCOUNTING
+ * ******************************************************************************************** */
+
+struct process_memory {
+    long rss_kb;       // VmRSS: resident set size now
+    long peak_rss_kb;  // VmHWM: peak resident set size since start (or reset_peak_rss())
+    long heap_in_use;  // bytes handed out by malloc and not yet freed (-1 if unknown)
+    long heap_free;    // bytes malloc holds but has not handed out (-1 if unknown)
+    long heap_mmap;    // bytes in large allocations served directly by mmap (-1 if unknown)
+};
+
+// Read a "Key:   1234 kB" line from /proc/self/status. Returns -1 if unavailable.
+inline long read_proc_status_kb(const char* key) {
+    FILE* f = fopen("/proc/self/status", "r");
+    if (f == NULL) {
+        return -1;
+    }
+    const size_t key_len = strlen(key);
+    char line[256];
+    long value = -1;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+            value = atol(line + key_len + 1);
+            break;
+        }
+    }
+    fclose(f);
+    return value;
+}
+
+inline process_memory get_process_memory() {
+    process_memory m;
+    m.rss_kb = read_proc_status_kb("VmRSS");
+    m.peak_rss_kb = read_proc_status_kb("VmHWM");
+#if HAVE_MALLINFO2
+    const struct mallinfo2 mi = mallinfo2();
+    m.heap_in_use = (long)mi.uordblks + (long)mi.hblkhd;
+    m.heap_free = (long)mi.fordblks;
+    m.heap_mmap = (long)mi.hblkhd;
+#else
+    m.heap_in_use = -1;
+    m.heap_free = -1;
+    m.heap_mmap = -1;
+#endif
+    return m;
+}
+
+// Reset VmHWM to the current RSS so the next phase's peak can be measured on its own.
+// Returns false if the kernel does not support it.
+inline bool reset_peak_rss() {
+    FILE* f = fopen("/proc/self/clear_refs", "w");
+    if (f == NULL) {
+        return false;
+    }
+    const bool ok = fputs("5", f) >= 0;
+    return (fclose(f) == 0) && ok;
+}
+
+inline void print_process_memory(const string& activity) {
+    const process_memory m = get_process_memory();
+    cout << "Memory after " << activity << ": rss=" << m.rss_kb << "kB peak_rss=" << m.peak_rss_kb
+         << "kB";
+    if (m.heap_in_use >= 0) {
+        cout << " heap_in_use=" << m.heap_in_use / 1024 << "kB heap_free=" << m.heap_free / 1024
+             << "kB heap_mmap=" << m.heap_mmap / 1024 << "kB";
+    }
+    cout << "\n\n";
+}
+
+// Footprint of one data structure: what it asked the allocator for vs the payload it holds
+inline void print_footprint(const string& name, const size_t num_elements,
+                            const size_t bytes_allocated, const size_t bytes_live) {
+    cout << name << " footprint: elements=" << num_elements << " allocated=" << bytes_allocated
+         << "B live=" << bytes_live << "B overhead_per_element="
+         << (num_elements > 0 ? (double)(bytes_allocated - bytes_live) / num_elements : 0)
+         << "B\n";
+}
+
+#endif  // MEM_STATS_H
@@ -0,0 +1,225 @@
+#ifndef MMAP_ARENA_H
+#define MMAP_ARENA_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#define ARENA_MAGIC 0x414e5241  // "ARNA" in little-endian
+#define ARENA_VERSION 1
+#define ARENA_NULL 0             // slot 0 is never handed out, so it doubles as a null link
+#define ARENA_HEADER_BYTES 4096  // header gets its own page so slots stay page-aligned
+#define ARENA_INITIAL_SLOTS 4096
+
+// madvise hints for the current access phase
+#define ARENA_ADVICE_NORMAL 0
+#define ARENA_ADVICE_SEQUENTIAL 1
+#define ARENA_ADVICE_RANDOM 2
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   PAGE FAULT COUNTERS
+ * ******************************************************************************************** */
+
+struct page_faults {
+    long minor;
+    long major;
+};
+
+inline page_faults get_page_faults() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    page_faults pf = {usage.ru_minflt, usage.ru_majflt};
+    return pf;
+}
+
+/* ******************************************************************************************** *
+ *   FILE-BACKED SLOT ARENA
+ *
+ *   [arena_header, padded to ARENA_HEADER_BYTES][slot 0 (unused)][slot 1][slot 2]...
+ *
+ *   Slots are fixed-size and addressed by 32-bit index rather than pointer, so links stored
+ *   inside slots stay valid when the file is grown and remapped at a different address.
+ *   Freed slots are threaded onto a free list through their first 4 bytes.
+ * ******************************************************************************************** */
+
+struct arena_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t slot_size;
+    uint32_t free_head;   // first free slot, ARENA_NULL if none
+    uint64_t next_slot;   // bump pointer: first slot never handed out
+    uint64_t capacity;    // number of slots the file currently holds
+    uint64_t live_slots;  // slots handed out and not freed
+    uint64_t root;        // owner-defined entry point (e.g. the root node of a tree)
+};
+
+class MmapArena {
+   private:
+    int fd = -1;
+    char* base = NULL;
+    size_t mapped_bytes = 0;
+    arena_header* header = NULL;
+
+    size_t bytes_for(uint64_t slots) const {
+        return ARENA_HEADER_BYTES + slots * header->slot_size;
+    }
+
+    bool map_file(size_t bytes) {
+        void* p = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p == MAP_FAILED) {
+            return false;
+        }
+        base = (char*)p;
+        mapped_bytes = bytes;
+        header = (arena_header*)base;
+        return true;
+    }
+
+    void grow() {
+        const uint64_t new_capacity = header->capacity * 2;
+        const size_t new_bytes = ARENA_HEADER_BYTES + new_capacity * header->slot_size;
+        if (ftruncate(fd, new_bytes) != 0) {
+            cerr << "Failed to grow arena file, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        void* p = mremap(base, mapped_bytes, new_bytes, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED) {
+            cerr << "Failed to remap arena, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        base = (char*)p;
+        mapped_bytes = new_bytes;
+        header = (arena_header*)base;
+        header->capacity = new_capacity;
+    }
+
+   public:
+    MmapArena() {}
+    ~MmapArena() { close(); }
+
+    MmapArena(const MmapArena&) = delete;
+    MmapArena& operator=(const MmapArena&) = delete;
+
+    // Open the arena at `path`, creating it if it does not exist. An existing file is reused
+    // (including its root and free list) if its slot size matches.
+    bool open(const char* path, const uint32_t slot_size) {
+        close();
+        if (slot_size < sizeof(uint32_t) || ARENA_HEADER_BYTES < sizeof(arena_header)) {
+            return false;
+        }
+
+        fd = ::open(path, O_RDWR | O_CREAT, 0644);
+        if (fd < 0) {
+            cerr << "Failed to open arena " << path << '\n';
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            close();
+            return false;
+        }
+
+        if (st.st_size == 0) {  // fresh file
+            const size_t bytes = ARENA_HEADER_BYTES + (size_t)ARENA_INITIAL_SLOTS * slot_size;
+            if (ftruncate(fd, bytes) != 0 || !map_file(bytes)) {
+                cerr << "Failed to initialise arena " << path << '\n';
+                close();
+                return false;
+            }
+            header->magic = ARENA_MAGIC;
+            header->version = ARENA_VERSION;
+            header->slot_size = slot_size;
+            header->free_head = ARENA_NULL;
+            header->next_slot = 1;  // skip the null slot
+            header->capacity = ARENA_INITIAL_SLOTS;
+            header->live_slots = 0;
+            header->root = ARENA_NULL;
+            return true;
+        }
+
+        if (!map_file(st.st_size) || header->magic != ARENA_MAGIC ||
+            header->version != ARENA_VERSION || header->slot_size != slot_size ||
+            (size_t)st.st_size != bytes_for(header->capacity)) {
+            cerr << "Arena " << path << " has an unsupported format\n";
+            close();
+            return false;
+        }
+        return true;
+    }
+
+    void close() {
+        if (base != NULL) {
+            msync(base, mapped_bytes, MS_SYNC);
+            munmap(base, mapped_bytes);
+        }
+        if (fd >= 0) {
+            ::close(fd);
+        }
+        fd = -1;
+        base = NULL;
+        mapped_bytes = 0;
+        header = NULL;
+    }
+
+    // NOTE: may grow and remap the file, which invalidates every pointer returned by at()
+    uint32_t alloc() {
+        if (header->free_head != ARENA_NULL) {
+            const uint32_t slot = header->free_head;
+            memcpy(&header->free_head, at(slot), sizeof(uint32_t));
+            header->live_slots++;
+            return slot;
+        }
+        if (header->next_slot >= UINT32_MAX) {
+            cerr << "Arena out of slot indices, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        if (header->next_slot == header->capacity) {
+            grow();
+        }
+        header->live_slots++;
+        return (uint32_t)header->next_slot++;
+    }
+
+    void free(const uint32_t slot) {
+        memcpy(at(slot), &header->free_head, sizeof(uint32_t));
+        header->free_head = slot;
+        header->live_slots--;
+    }
+
+    void* at(const uint32_t slot) const {
+        return base + ARENA_HEADER_BYTES + (size_t)slot * header->slot_size;
+    }
+
+    uint64_t get_root() const { return header->root; }
+
+    void set_root(const uint64_t root) { header->root = root; }
+
+    uint64_t live_slots() const { return header->live_slots; }
+
+    size_t file_bytes() const { return mapped_bytes; }
+
+    // Flush every dirty page to the file; after this returns the file is a consistent image
+    bool checkpoint() { return msync(base, mapped_bytes, MS_SYNC) == 0; }
+
+    // Hint the kernel about the upcoming access pattern (e.g. bulk load vs random lookups)
+    void advise(const int advice) {
+        int flag = MADV_NORMAL;
+        if (advice == ARENA_ADVICE_SEQUENTIAL) {
+            flag = MADV_SEQUENTIAL;
+        } else if (advice == ARENA_ADVICE_RANDOM) {
+            flag = MADV_RANDOM;
+        }
+        madvise(base, mapped_bytes, flag);
+    }
+};
+
+#endif  // MMAP_ARENA_H
@@ -0,0 +1,144 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// Counter indexes
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_CACHE_MISSES 2
+#define PERF_BRANCH_MISSES 3
+#define PERF_DTLB_MISSES 4
+#define PERF_NUM_COUNTERS 5
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   HARDWARE PERFORMANCE COUNTERS
+ *
+ *   Thin wrapper over Linux perf_event_open, counting user-space events for this thread. Each
+ *   counter is opened independently, so a missing PMU event (common in VMs and containers, or
+ *   with a restrictive perf_event_paranoid) only disables that counter. If nothing can be
+ *   opened, start()/stop() are no-ops and print() says why.
+ * ******************************************************************************************** */
+
+static const char* const PERF_COUNTER_NAMES[PERF_NUM_COUNTERS] = {
+    "cycles", "instructions", "cache_misses", "branch_misses", "dtlb_misses"};
+
+class PerfCounters {
+   private:
+    int fds[PERF_NUM_COUNTERS];
+    uint64_t values[PERF_NUM_COUNTERS];
+    int open_errno = 0;  // errno of the first counter that failed to open
+
+    static int open_counter(const uint32_t type, const uint64_t config) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+   public:
+    PerfCounters() {
+        const uint32_t types[PERF_NUM_COUNTERS] = {PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                   PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE,
+                                                   PERF_TYPE_HW_CACHE};
+        const uint64_t configs[PERF_NUM_COUNTERS] = {
+            PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES,
+            PERF_COUNT_HW_BRANCH_MISSES,
+            PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            fds[i] = open_counter(types[i], configs[i]);
+            values[i] = 0;
+            if (fds[i] < 0 && open_errno == 0) {
+                open_errno = errno;
+            }
+        }
+    }
+
+    ~PerfCounters() {
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            if (fds[i] >= 0) {
+                close(fds[i]);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool available(const int counter) const { return fds[counter] >= 0; }
+
+    bool any_available() const {
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            if (available(i)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void start() {
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            if (available(i)) {
+                ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+                ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    // Stop counting and latch the values, scaled up if the kernel had to multiplex counters
+    void stop() {
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            if (available(i)) {
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            values[i] = 0;
+            uint64_t data[3];  // value, time_enabled, time_running
+            if (available(i) && read(fds[i], data, sizeof(data)) == sizeof(data) && data[2] > 0) {
+                values[i] = (uint64_t)((double)data[0] * data[1] / data[2]);
+            }
+        }
+    }
+
+    uint64_t value(const int counter) const { return values[counter]; }
+
+    // Print counter values per operation, e.g. next to print_time()
+    void print(const long num_operations) const {
+        if (!any_available()) {
+            cout << "Perf counters unavailable: " << strerror(open_errno) << "\n\n";
+            return;
+        }
+        cout << "Per op:";
+        for (int i = 0; i < PERF_NUM_COUNTERS; i++) {
+            if (available(i)) {
+                cout << ' ' << PERF_COUNTER_NAMES[i] << '='
+                     << (double)values[i] / num_operations;
+            }
+        }
+        if (available(PERF_CYCLES) && available(PERF_INSTRUCTIONS) && values[PERF_CYCLES] > 0) {
+            cout << " ipc=" << (double)values[PERF_INSTRUCTIONS] / values[PERF_CYCLES];
+        }
+        cout << "\n\n";
+    }
+};
+
+#endif  // PERF_COUNTERS_H
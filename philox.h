@@ -0,0 +1,128 @@
+#ifndef PHILOX_H
+#define PHILOX_H
+
+#include <cstdint>
+
+// Philox4x32 round constants (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3", 2011)
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+#define FEISTEL_ROUNDS 4
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   COUNTER-BASED RANDOM NUMBERS
+ *
+ *   Philox4x32-10 maps (key, counter) to 128 random bits with no state in between, so the n-th
+ *   number of a stream can be computed directly by any thread. Streams are separated by putting
+ *   a stream id in the high counter words.
+ * ******************************************************************************************** */
+
+struct philox_block {
+    uint32_t v[4];
+};
+
+class Philox {
+   private:
+    uint32_t key0;
+    uint32_t key1;
+
+    static void mulhilo(const uint32_t a, const uint32_t b, uint32_t& hi, uint32_t& lo) {
+        const uint64_t product = (uint64_t)a * b;
+        hi = (uint32_t)(product >> 32);
+        lo = (uint32_t)product;
+    }
+
+   public:
+    explicit Philox(const uint64_t seed) : key0((uint32_t)seed), key1((uint32_t)(seed >> 32)) {}
+
+    philox_block block(const uint64_t index, const uint32_t stream) const {
+        philox_block c = {{(uint32_t)index, (uint32_t)(index >> 32), stream, 0}};
+        uint32_t k0 = key0;
+        uint32_t k1 = key1;
+        for (int r = 0; r < PHILOX_ROUNDS; r++) {
+            uint32_t hi0, lo0, hi1, lo1;
+            mulhilo(PHILOX_M0, c.v[0], hi0, lo0);
+            mulhilo(PHILOX_M1, c.v[2], hi1, lo1);
+            c = {{hi1 ^ c.v[1] ^ k0, lo1, hi0 ^ c.v[3] ^ k1, lo0}};
+            k0 += PHILOX_W0;
+            k1 += PHILOX_W1;
+        }
+        return c;
+    }
+
+    uint32_t u32(const uint64_t index, const uint32_t stream) const {
+        return block(index, stream).v[0];
+    }
+
+    uint64_t u64(const uint64_t index, const uint32_t stream) const {
+        const philox_block b = block(index, stream);
+        return ((uint64_t)b.v[1] << 32) | b.v[0];
+    }
+
+    // Uniform in [0, bound), by multiply-shift (bias below 2^-32 * bound)
+    uint32_t below(const uint64_t index, const uint32_t stream, const uint32_t bound) const {
+        return (uint32_t)(((uint64_t)u32(index, stream) * bound) >> 32);
+    }
+};
+
+/* ******************************************************************************************** *
+ *   RANDOM PERMUTATION OF [0, n)
+ *
+ *   A balanced Feistel network is a bijection on 2h-bit integers for any round function. Cycle
+ *   walking (re-applying it until the result is below n) restricts it to [0, n); 2^2h < 4n, so
+ *   that takes under four applications on average. Any position can be mapped independently.
+ * ******************************************************************************************** */
+
+class FeistelPermutation {
+   private:
+    uint64_t n;
+    int half_bits;
+    uint64_t half_mask;
+    uint64_t round_keys[FEISTEL_ROUNDS];
+
+    static uint64_t mix(uint64_t x) {  // splitmix64 finaliser
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ULL;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBULL;
+        return x ^ (x >> 31);
+    }
+
+    uint64_t encrypt(const uint64_t x) const {
+        uint64_t left = x >> half_bits;
+        uint64_t right = x & half_mask;
+        for (int r = 0; r < FEISTEL_ROUNDS; r++) {
+            const uint64_t next = left ^ (mix(right ^ round_keys[r]) & half_mask);
+            left = right;
+            right = next;
+        }
+        return (left << half_bits) | right;
+    }
+
+   public:
+    FeistelPermutation(const uint64_t n, const Philox& philox, const uint32_t stream) : n(n) {
+        half_bits = 1;
+        while (((uint64_t)1 << (2 * half_bits)) < n) {
+            half_bits++;
+        }
+        half_mask = ((uint64_t)1 << half_bits) - 1;
+        for (int r = 0; r < FEISTEL_ROUNDS; r++) {
+            round_keys[r] = philox.u64(r, stream);
+        }
+    }
+
+    uint64_t operator()(const uint64_t i) const {
+        uint64_t x = encrypt(i);
+        while (x >= n) {
+            x = encrypt(x);
+        }
+        return x;
+    }
+};
+
+#endif  // PHILOX_H
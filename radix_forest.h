@@ -0,0 +1,154 @@
+#ifndef RADIX_FOREST_H
+#define RADIX_FOREST_H
+
+#include <climits>
+#include <cstdlib>
+#include <iostream>
+
+#include "data_structures.h"
+#include "treap_ops.h"
+
+#define FOREST_DEFAULT_BUCKET_BITS 14  // 1024-key buckets: ~100 keys each for 1M random keys
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   RADIX-PARTITIONED TREAP FOREST
+ *
+ *   Keys are bounded to 0..KEY_MAX, so the top of every descent is predictable: a direct-mapped
+ *   table indexed by the high bits of the key holds the root of a small treap per bucket, and an
+ *   operation goes straight to its bucket's root instead of walking the top levels of one big
+ *   treap. Buckets cover consecutive key ranges, so visiting them in order gives ordered
+ *   iteration and range queries. Each bucket is an ordinary treap of treap_nodes, maintained with
+ *   the shared operations in treap_ops.h, and keeps its own expected O(log bucket size) depth.
+ * ******************************************************************************************** */
+
+class RadixTreapForest {
+   private:
+    treap_node** roots;  // one treap per bucket; NULL => empty
+    size_t num_buckets;
+    int shift;  // bucket of key = key >> shift
+    size_t num_nodes;
+
+    static int key_bits() {
+        int bits = 1;
+        while ((KEY_MAX >> bits) != 0) {
+            bits++;
+        }
+        return bits;
+    }
+
+    static bool in_key_range(const int key) { return 0 <= key && key <= KEY_MAX; }
+
+    treap_node*& root_of(const int key) { return roots[key >> shift]; }
+
+   public:
+    // Buckets cover 2^(key bits - bucket_bits) keys each (at least one key)
+    explicit RadixTreapForest(int bucket_bits = FOREST_DEFAULT_BUCKET_BITS) : num_nodes(0) {
+        bucket_bits = max(0, min(bucket_bits, key_bits()));
+        shift = key_bits() - bucket_bits;
+        num_buckets = (size_t)(KEY_MAX >> shift) + 1;
+        roots = (treap_node**)calloc(num_buckets, sizeof(treap_node*));
+        if (roots == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~RadixTreapForest() {
+        for (size_t b = 0; b < num_buckets; b++) {
+            treap_dealloc(roots[b]);
+        }
+        free(roots);
+    }
+
+    RadixTreapForest(const RadixTreapForest&) = delete;
+    RadixTreapForest& operator=(const RadixTreapForest&) = delete;
+
+    // Perform insertion operation. Keys must be in 0..KEY_MAX.
+    void insert(element e) {
+        if (!in_key_range(e.KEY)) {
+            cerr << "Key " << e.KEY << " outside 0.." << KEY_MAX << ", aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        treap_node* n = new treap_node(e, rng.rand_priority());
+        num_nodes++;
+        treap_node*& root = root_of(e.KEY);
+        root = treap_insert(root, n);
+    }
+
+    // Perform deletion operation
+    void delet(const int key) {
+        if (in_key_range(key)) {
+            treap_node*& root = root_of(key);
+            root = treap_delete_key(root, key, [this](treap_node* node) {
+                delete (node);
+                num_nodes--;
+            });
+        }
+    }
+
+    // Perform search operation
+    element* search(const int key) {
+        if (!in_key_range(key)) {
+            return NULL;
+        }
+        treap_node* node = root_of(key);
+        while (node != NULL && node->get_key() != key) {
+            node = key < node->get_key() ? node->left : node->right;
+        }
+        return node != NULL ? &node->elem : NULL;
+    }
+
+    // Call visit(element&) for every element with lo <= key <= hi, in key order
+    template <class Visitor>
+    void for_each_in_range(int lo, int hi, Visitor visit) {
+        lo = max(lo, 0);
+        hi = min(hi, KEY_MAX);
+        if (lo > hi) {
+            return;
+        }
+        auto visit_node = [&visit](treap_node* node) { visit(node->elem); };
+        for (int b = lo >> shift; b <= (hi >> shift); b++) {
+            treap_range(roots[b], lo, hi, visit_node);
+        }
+    }
+
+    // Call visit(element&) for every element, in key order
+    template <class Visitor>
+    void for_each(Visitor visit) {
+        for_each_in_range(0, KEY_MAX, visit);
+    }
+
+    // Perform range scan: number of elements with lo <= key <= hi
+    int range_scan(const int lo, const int hi) {
+        int count = 0;
+        for_each_in_range(lo, hi, [&count](const element&) { count++; });
+        return count;
+    }
+
+    size_t size() { return num_nodes; }
+
+    size_t buckets() { return num_buckets; }
+
+    // Bytes requested for nodes and the bucket table (excludes per-allocation malloc overhead)
+    size_t bytes_allocated() {
+        return num_nodes * sizeof(treap_node) + num_buckets * sizeof(treap_node*);
+    }
+
+    size_t bytes_live() { return num_nodes * sizeof(element); }
+
+    // Every bucket is a treap and holds only keys of its own range; the node count adds up
+    bool validate() {
+        size_t count = 0;
+        for (size_t b = 0; b < num_buckets; b++) {
+            const int lo = (int)(b << shift);
+            const int hi = (int)min(((b + 1) << shift) - 1, (size_t)KEY_MAX);
+            if (!treap_valid(roots[b], lo, hi, count)) {
+                return false;
+            }
+        }
+        return count == num_nodes;
+    }
+};
+
+#endif  // RADIX_FOREST_H
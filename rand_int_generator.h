@@ -1,151 +1,201 @@
-#ifndef RAND_INT_GENERATOR_H
-#define RAND_INT_GENERATOR_H
-
-#include <algorithm>
-#include <cassert>
-#include <climits>
-#include <iostream>
-#include <iterator>
-#include <random>
-#include <vector>
-
-// Operation Indexes
-#define I_OPTYPE 0  // applies to insertion_op, deletion_op, search_op
-#define I_OPKEY 1   // applies to deletion_op, search_op
-#define I_OPELEM 1  // applies to insertion_op
-
-// Operation Labels
-#define OPTYPE_INSERTION 1
-#define OPTYPE_DELETION 2
-#define OPTYPE_SEARCH 3
-
-#define KEY_MAX 10000000
-#define PRIORITY_MAX INT_MAX
-
-using namespace std;
-
-/* ******************************************************************************************** *
- *   ELEMENTS AND OPERATIONS
- * ******************************************************************************************** */
-
-struct element {
-    int ID;
-    int KEY;
-};
-
-struct insertion_op {
-    element ELEM;
-};
-
-struct deletion_op {
-    int KEY;
-};
-
-struct search_op {
-    int KEY;
-};
-
-/* ******************************************************************************************** *
- *   RANDOM NUMBER GENERATION
- * ******************************************************************************************** */
-
-class RandIntGenerator {
-   private:
-    random_device rd;
-    mt19937 engine{rd()};
-    uniform_int_distribution<> id_dist;
-    uniform_int_distribution<> key_dist;
-    uniform_int_distribution<> prio_dist;
-
-   public:
-    RandIntGenerator() : id_dist(1, 9), key_dist(0, KEY_MAX), prio_dist(0, PRIORITY_MAX) {}
-
-    int rand_id() { return id_dist(engine); }
-
-    int rand_id(int max) {
-        uniform_int_distribution<> custom_dist(1, max);
-        return custom_dist(engine);
-    }
-
-    int rand_key() { return key_dist(engine); }
-
-    int rand_priority() { return prio_dist(engine); }
-
-    /* @param type{int} OPTYPE_INSERTION, OPTYPE_DELETION, or OPTYPE_SEARCH*/
-    vector<int> rand_update_sequence2(int num_updates, int type1, int count1, int type2,
-                                      int count2) {
-        assert(("Invalid input for type1: expected an OPTYPE",
-                type1 == OPTYPE_INSERTION || type1 == OPTYPE_DELETION || type1 == OPTYPE_SEARCH));
-        assert(("Invalid input for type2: expected an OPTYPE",
-                type2 == OPTYPE_INSERTION || type2 == OPTYPE_DELETION || type2 == OPTYPE_SEARCH));
-
-        assert(("Incorrect input: Expected count1 + count2 == num_updates",
-                count1 + count2 == num_updates));
-
-        vector<int> vec;
-
-        for (int i = 0; i < count1; i++) {
-            vec.push_back(type1);
-        }
-        for (int i = 0; i < count2; i++) {
-            vec.push_back(type2);
-        }
-
-        std::shuffle(vec.begin(), vec.end(), engine);
-
-        cout << "shuffled vector: length=" << vec.size() << " vec=[";
-        for (int i = 0; i < 10; i++) {
-            cout << vec[i] << ',';
-        }
-        cout << "...";
-        for (int i = num_updates - 10; i < num_updates; i++) {
-            cout << ',' << vec[i];
-        }
-        cout << "]\n";
-
-        return vec;
-    }
-
-    /* @param type{int} OPTYPE_INSERTION, OPTYPE_DELETION, or OPTYPE_SEARCH*/
-    vector<int> rand_update_sequence3(int num_updates, int type1, int count1, int type2,
-                                      int count2, int type3, int count3) {
-        assert(("Incorrect input: Expected count1 + count2 + count 3 == num_updates",
-                count1 + count2 + count3 == num_updates));
-        assert(("Invalid input for type1: expected an OPTYPE",
-                type1 == OPTYPE_INSERTION || type1 == OPTYPE_DELETION || type1 == OPTYPE_SEARCH));
-        assert(("Invalid input for type2: expected an OPTYPE",
-                type2 == OPTYPE_INSERTION || type2 == OPTYPE_DELETION || type2 == OPTYPE_SEARCH));
-        assert(("Invalid input for type3: expected an OPTYPE",
-                type3 == OPTYPE_INSERTION || type3 == OPTYPE_DELETION || type3 == OPTYPE_SEARCH));
-
-        vector<int> vec;
-
-        for (int i = 0; i < count1; i++) {
-            vec.push_back(type1);
-        }
-        for (int i = 0; i < count2; i++) {
-            vec.push_back(type2);
-        }
-        for (int i = 0; i < count3; i++) {
-            vec.push_back(type3);
-        }
-
-        std::shuffle(vec.begin(), vec.end(), engine);
-
-        cout << "shuffled vector: length=" << vec.size() << " vec=[";
-        for (int i = 0; i < 10; i++) {
-            cout << vec[i] << ',';
-        }
-        cout << "...";
-        for (int i = num_updates - 10; i < num_updates; i++) {
-            cout << ',' << vec[i];
-        }
-        cout << "]\n";
-
-        return vec;
-    }
-};
-
-extern RandIntGenerator rng; // Global Random Int Generator for (id, key, priority), and update sequences
-
-#endif
+#ifndef RAND_INT_GENERATOR_H
+#define RAND_INT_GENERATOR_H
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <vector>
+
+// Operation Indexes
+#define I_OPTYPE 0  // applies to insertion_op, deletion_op, search_op
+#define I_OPKEY 1   // applies to deletion_op, search_op
+#define I_OPELEM 1  // applies to insertion_op
+
+// Operation Labels
+#define OPTYPE_INSERTION 1
+#define OPTYPE_DELETION 2
+#define OPTYPE_SEARCH 3
+#define OPTYPE_RANGE 4  // range scan over [ELEM.KEY, ELEM.KEY + ELEM.ID]
+#define OPTYPE_MAX OPTYPE_RANGE
+
+#define KEY_MAX 10000000
+#define PRIORITY_MAX INT_MAX
+
+#define FIB_HASH_MULTIPLIER 2654435769u  // 2^32 / golden ratio
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   ELEMENTS AND OPERATIONS
+ * ******************************************************************************************** */
+
+struct element {
+    int ID;
+    int KEY;
+};
+
+struct insertion_op {
+    element ELEM;
+};
+
+struct deletion_op {
+    int KEY;
+};
+
+struct search_op {
+    int KEY;
+};
+
+// A single operation of any type, in sequence order. Deletions and searches only use ELEM.KEY;
+// range scans cover keys ELEM.KEY to ELEM.KEY + ELEM.ID inclusive.
+struct packed_op {
+    int TYPE;
+    element ELEM;
+};
+
+// Fibonacci hashing of a key to its top 32 - shift bits, for power-of-two tables of keys.
+// Consecutive keys land far apart.
+static inline uint32_t fib_hash(const int key, const int shift) {
+    return ((uint32_t)key * FIB_HASH_MULTIPLIER) >> shift;
+}
+
+/* ******************************************************************************************** *
+ *   RANDOM NUMBER GENERATION
+ * ******************************************************************************************** */
+
+class RandIntGenerator {
+   private:
+    random_device rd;
+    mt19937 engine{rd()};
+    uniform_int_distribution<> id_dist;
+    uniform_int_distribution<> key_dist;
+    uniform_int_distribution<> prio_dist;
+
+   public:
+    RandIntGenerator() : id_dist(1, 9), key_dist(0, KEY_MAX), prio_dist(0, PRIORITY_MAX) {}
+
+    int rand_id() { return id_dist(engine); }
+
+    int rand_id(int max) {
+        uniform_int_distribution<> custom_dist(1, max);
+        return custom_dist(engine);
+    }
+
+    int rand_key() { return key_dist(engine); }
+
+    int rand_priority() { return prio_dist(engine); }
+
+    // Uniform integer in [lo, hi]
+    int rand_range(int lo, int hi) {
+        uniform_int_distribution<> custom_dist(lo, hi);
+        return custom_dist(engine);
+    }
+
+    // Restart the engine from a fixed seed, e.g. to make a trial reproducible
+    void seed(const uint64_t seed) {
+        seed_seq seq{(uint32_t)seed, (uint32_t)(seed >> 32)};
+        engine.seed(seq);
+    }
+
+    template <class RandomIt>
+    void shuffle(RandomIt first, RandomIt last) {
+        std::shuffle(first, last, engine);
+    }
+
+    // Seed for a counter-based generator (see philox.h). The two draws are sequenced, so the
+    // same engine state gives the same seed with every compiler.
+    uint64_t rand_seed() {
+        const uint64_t hi = engine();
+        return (hi << 32) | engine();
+    }
+
+    // Uniform real in [0, 1)
+    double rand_unit() {
+        uniform_real_distribution<double> unit_dist(0.0, 1.0);
+        return unit_dist(engine);
+    }
+
+    /* @param type{int} OPTYPE_INSERTION, OPTYPE_DELETION, or OPTYPE_SEARCH*/
+    vector<int> rand_update_sequence2(int num_updates, int type1, int count1, int type2,
+                                      int count2) {
+        assert(("Invalid input for type1: expected an OPTYPE",
+                type1 == OPTYPE_INSERTION || type1 == OPTYPE_DELETION || type1 == OPTYPE_SEARCH));
+        assert(("Invalid input for type2: expected an OPTYPE",
+                type2 == OPTYPE_INSERTION || type2 == OPTYPE_DELETION || type2 == OPTYPE_SEARCH));
+
+        assert(("Incorrect input: Expected count1 + count2 == num_updates",
+                count1 + count2 == num_updates));
+
+        vector<int> vec;
+
+        for (int i = 0; i < count1; i++) {
+            vec.push_back(type1);
+        }
+        for (int i = 0; i < count2; i++) {
+            vec.push_back(type2);
+        }
+
+        std::shuffle(vec.begin(), vec.end(), engine);
+
+        cout << "shuffled vector: length=" << vec.size() << " vec=[";
+        for (int i = 0; i < 10; i++) {
+            cout << vec[i] << ',';
+        }
+        cout << "...";
+        for (int i = num_updates - 10; i < num_updates; i++) {
+            cout << ',' << vec[i];
+        }
+        cout << "]\n";
+
+        return vec;
+    }
+
+    /* @param type{int} OPTYPE_INSERTION, OPTYPE_DELETION, or OPTYPE_SEARCH*/
+    vector<int> rand_update_sequence3(int num_updates, int type1, int count1, int type2,
+                                      int count2, int type3, int count3) {
+        assert(("Incorrect input: Expected count1 + count2 + count 3 == num_updates",
+                count1 + count2 + count3 == num_updates));
+        assert(("Invalid input for type1: expected an OPTYPE",
+                type1 == OPTYPE_INSERTION || type1 == OPTYPE_DELETION || type1 == OPTYPE_SEARCH));
+        assert(("Invalid input for type2: expected an OPTYPE",
+                type2 == OPTYPE_INSERTION || type2 == OPTYPE_DELETION || type2 == OPTYPE_SEARCH));
+        assert(("Invalid input for type3: expected an OPTYPE",
+                type3 == OPTYPE_INSERTION || type3 == OPTYPE_DELETION || type3 == OPTYPE_SEARCH));
+
+        vector<int> vec;
+
+        for (int i = 0; i < count1; i++) {
+            vec.push_back(type1);
+        }
+        for (int i = 0; i < count2; i++) {
+            vec.push_back(type2);
+        }
+        for (int i = 0; i < count3; i++) {
+            vec.push_back(type3);
+        }
+
+        std::shuffle(vec.begin(), vec.end(), engine);
+
+        cout << "shuffled vector: length=" << vec.size() << " vec=[";
+        for (int i = 0; i < 10; i++) {
+            cout << vec[i] << ',';
+        }
+        cout << "...";
+        for (int i = num_updates - 10; i < num_updates; i++) {
+            cout << ',' << vec[i];
+        }
+        cout << "]\n";
+
+        return vec;
+    }
+};
+
+// Random Int Generator for (id, key, priority), and update sequences. One per thread, so
+// parallel trials neither race on it nor share a sequence.
+extern thread_local RandIntGenerator rng;
+
+#endif
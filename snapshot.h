@@ -0,0 +1,205 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <iostream>
+#include <vector>
+
+#include "rand_int_generator.h"
+
+#define SNAPSHOT_MAGIC 0x50415254  // "TRAP" in little-endian
+#define SNAPSHOT_VERSION 1
+#define SNAPSHOT_HAS_LEFT 1u  // low bit of snapshot_node::links
+#define SNAPSHOT_MAX_NODES (UINT32_MAX >> 1)  // indices are 31 bits
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   ON-DISK SNAPSHOT FORMAT
+ *
+ *   [snapshot_header][snapshot_node * num_nodes]
+ *
+ *   Nodes are stored in pre-order, so the root is node 0 and a left child (if present) always
+ *   immediately follows its parent. Only the right child needs an explicit index; it is packed
+ *   into `links` together with the has-left flag. Indices are 31 bits, and index 0 (the root) is
+ *   never a right child, so a right index of 0 means "no right child".
+ * ******************************************************************************************** */
+
+struct snapshot_header {
+    uint32_t magic;
+    uint32_t version;
+    uint64_t num_nodes;
+};
+
+struct snapshot_node {
+    element elem;
+    int priority;
+    uint32_t links;  // (right_index << 1) | SNAPSHOT_HAS_LEFT
+
+    bool has_left() const { return (links & SNAPSHOT_HAS_LEFT) != 0; }
+
+    uint32_t right() const { return links >> 1; }
+};
+
+/* ******************************************************************************************** *
+ *   MAPPED TREAP (READ-ONLY)
+ * ******************************************************************************************** */
+
+// Serves searches directly from an mmap'd snapshot without deserialising it.
+// Use RandomisedTreap::thaw() to turn a snapshot back into a writable treap.
+class MappedTreap {
+   private:
+    void* base = MAP_FAILED;
+    size_t length = 0;
+    const snapshot_node* nodes = NULL;
+    uint64_t num_nodes = 0;
+
+    // A child must come after its parent and lie inside the mapping. Checking this on every
+    // step keeps a descent over a corrupt file inside the mapping and stops it from looping.
+    uint32_t checked_child(const uint32_t parent, const uint32_t child) const {
+        if (child <= parent || child >= num_nodes) {
+            cerr << "Snapshot is corrupt, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        return child;
+    }
+
+   public:
+    MappedTreap() {}
+    ~MappedTreap() { close(); }
+
+    MappedTreap(const MappedTreap&) = delete;
+    MappedTreap& operator=(const MappedTreap&) = delete;
+
+    bool open_mapped(const char* path) {
+        close();
+
+        int fd = open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "Failed to open snapshot " << path << '\n';
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(snapshot_header)) {
+            cerr << "Snapshot " << path << " is truncated\n";
+            ::close(fd);
+            return false;
+        }
+
+        length = st.st_size;
+        base = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);  // the mapping keeps the file alive
+        if (base == MAP_FAILED) {
+            cerr << "Failed to mmap snapshot " << path << '\n';
+            length = 0;
+            return false;
+        }
+
+        // num_nodes is checked against the index range first, so the length cannot overflow
+        const snapshot_header* header = (const snapshot_header*)base;
+        if (header->magic != SNAPSHOT_MAGIC || header->version != SNAPSHOT_VERSION ||
+            header->num_nodes > SNAPSHOT_MAX_NODES ||
+            length != sizeof(snapshot_header) + header->num_nodes * sizeof(snapshot_node)) {
+            cerr << "Snapshot " << path << " has an unsupported format\n";
+            close();
+            return false;
+        }
+
+        // The links are not walked here, so opening touches only the header; search() and
+        // thaw() check each link they follow
+        num_nodes = header->num_nodes;
+        nodes = (const snapshot_node*)(header + 1);
+        madvise(base, length, MADV_RANDOM);  // searches touch one node per level
+        return true;
+    }
+
+    void close() {
+        if (base != MAP_FAILED) {
+            munmap(base, length);
+        }
+        base = MAP_FAILED;
+        length = 0;
+        nodes = NULL;
+        num_nodes = 0;
+    }
+
+    bool is_open() const { return base != MAP_FAILED; }
+
+    uint64_t size() const { return num_nodes; }
+
+    const snapshot_node* node_at(uint64_t i) const { return &nodes[i]; }
+
+    // Index of node i's left or right child, or 0 if it has none (0 is never a child)
+    uint32_t left_child(const uint32_t i) const {
+        return nodes[i].has_left() ? checked_child(i, i + 1) : 0;
+    }
+
+    uint32_t right_child(const uint32_t i) const {
+        return nodes[i].right() != 0 ? checked_child(i, nodes[i].right()) : 0;
+    }
+
+    /* Full check of the links, not needed before searching: they must describe one tree in
+     * pre-order, so walking it from the root, with the left child before the right, visits node
+     * 0, 1, 2, ... num_nodes - 1 in turn. Reads every node, so it faults in the whole file. */
+    bool validate() const {
+        vector<uint32_t> pending;  // right children still to visit, innermost last
+        uint64_t next = 0;         // index the walk must reach next
+        if (num_nodes > 0) {
+            pending.push_back(0);
+        }
+        while (!pending.empty()) {
+            uint32_t i = pending.back();
+            pending.pop_back();
+            while (true) {
+                if (i != next) {
+                    return false;
+                }
+                next++;
+                const snapshot_node* node = &nodes[i];
+                if (node->right() != 0) {
+                    if (node->right() >= num_nodes) {
+                        return false;
+                    }
+                    pending.push_back(node->right());
+                }
+                if (!node->has_left()) {
+                    break;
+                }
+                i = i + 1;
+                if (i >= num_nodes) {
+                    return false;
+                }
+            }
+        }
+        return next == num_nodes;
+    }
+
+    // Same descent as RandomisedTreap::search_node, over node indices
+    const element* search(const int key) const {
+        if (num_nodes == 0) {
+            return NULL;
+        }
+        uint32_t i = 0;
+        while (true) {
+            const snapshot_node* node = &nodes[i];
+            if (node->elem.KEY == key) {
+                return &node->elem;
+            }
+            if (key < node->elem.KEY && node->has_left()) {  // go left
+                i = left_child(i);
+            } else if (node->elem.KEY < key && node->right() != 0) {  // go right
+                i = right_child(i);
+            } else {
+                return NULL;
+            }
+        }
+    }
+};
+
+#endif  // SNAPSHOT_H
@@ -0,0 +1,83 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <iostream>
+
+#define CACHE_LINE_SIZE 64
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   BOUNDED SINGLE-PRODUCER SINGLE-CONSUMER RING BUFFER
+ *
+ *   Lock-free: the producer only writes `tail` and the consumer only writes `head`, each with
+ *   release ordering, and each side keeps a cached copy of the other's index so the shared cache
+ *   line is read only when the ring looks full (producer) or empty (consumer). Indices grow
+ *   without wrapping and are masked, so the capacity must be a power of two.
+ * ******************************************************************************************** */
+
+template <class T>
+class SpscRing {
+   private:
+    T* slots;
+    size_t mask;
+
+    alignas(CACHE_LINE_SIZE) atomic<size_t> head;  // next slot to pop, written by the consumer
+    size_t cached_tail;                             // consumer's copy of tail
+
+    alignas(CACHE_LINE_SIZE) atomic<size_t> tail;  // next slot to push, written by the producer
+    size_t cached_head;                             // producer's copy of head
+
+   public:
+    explicit SpscRing(const size_t capacity) : mask(capacity - 1), head(0), cached_tail(0),
+                                                tail(0), cached_head(0) {
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            cerr << "Ring capacity must be a power of two, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+        slots = (T*)malloc(capacity * sizeof(T));
+        if (slots == NULL) {  // Check allocation successful
+            cerr << "Failed to allocate, aborting...\n";
+            exit(EXIT_FAILURE);
+        }
+    }
+    ~SpscRing() { free(slots); }
+
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    size_t capacity() const { return mask + 1; }
+
+    // Producer only. Returns false if the ring is full.
+    bool try_push(const T& item) {
+        const size_t t = tail.load(memory_order_relaxed);
+        if (t - cached_head > mask) {
+            cached_head = head.load(memory_order_acquire);
+            if (t - cached_head > mask) {
+                return false;
+            }
+        }
+        slots[t & mask] = item;
+        tail.store(t + 1, memory_order_release);
+        return true;
+    }
+
+    // Consumer only. Returns false if the ring is empty.
+    bool try_pop(T& item) {
+        const size_t h = head.load(memory_order_relaxed);
+        if (h == cached_tail) {
+            cached_tail = tail.load(memory_order_acquire);
+            if (h == cached_tail) {
+                return false;
+            }
+        }
+        item = slots[h & mask];
+        head.store(h + 1, memory_order_release);
+        return true;
+    }
+};
+
+#endif  // SPSC_RING_H
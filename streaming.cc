@@ -0,0 +1,264 @@
+#include "streaming.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+#include "mem_stats.h"
+
+using namespace std;
+
+// An operation in flight, stamped when it was pushed
+struct stream_item {
+    packed_op op;
+    uint64_t enqueue_tsc;
+};
+
+/* ******************************************************************************************** *
+ *   CONFIGURATION PARSING
+ * ******************************************************************************************** */
+
+static bool apply_stream_option(const string& key, const string& value, stream_config& config) {
+    if (key == "engine") {
+        bool known = false;
+        for_each_engine([&value, &known](auto, const engine_info& info) {
+            known = known || value == info.name;
+        });
+        if (!known) {
+            cerr << "Unknown engine: " << value << '\n';
+            return false;
+        }
+        config.engine = value;
+    } else if (key == "trace") {
+        config.trace_path = value;
+    } else if (key == "ops") {
+        config.num_operations = strtoull(value.c_str(), NULL, 10);
+    } else if (key == "seconds") {
+        config.seconds = atof(value.c_str());
+    } else if (key == "ring") {
+        config.ring_capacity = strtoull(value.c_str(), NULL, 10);
+        const size_t capacity = config.ring_capacity;
+        if (capacity < 2 || (capacity & (capacity - 1)) != 0) {
+            cerr << "Ring capacity must be a power of two\n";
+            return false;
+        }
+    } else if (key == "mix") {  // e.g. 90:5:5
+        if (sscanf(value.c_str(), "%d:%d:%d", &config.insert_pct, &config.delete_pct,
+                   &config.search_pct) != 3 ||
+            config.insert_pct < 0 || config.delete_pct < 0 || config.search_pct < 0 ||
+            config.insert_pct + config.delete_pct + config.search_pct != 100) {
+            cerr << "Mix must be insert:delete:search percentages summing to 100\n";
+            return false;
+        }
+    } else if (key == "seed") {
+        config.seed = strtoull(value.c_str(), NULL, 10);
+    } else {
+        cerr << "Unknown option: " << key << '\n';
+        return false;
+    }
+    return true;
+}
+
+// Options are --key=value, applied left to right
+bool parse_stream_args(int argc, char** argv, stream_config& config) {
+    bool ops_given = false;
+    for (int i = 0; i < argc; i++) {
+        const string arg = argv[i];
+        const size_t eq = arg.find('=');
+        if (arg.compare(0, 2, "--") != 0 || eq == string::npos) {
+            cerr << "Expected --key=value, got " << arg << '\n';
+            return false;
+        }
+        if (!apply_stream_option(arg.substr(2, eq - 2), arg.substr(eq + 1), config)) {
+            return false;
+        }
+        ops_given = ops_given || arg.compare(0, eq, "--ops") == 0;
+    }
+    // The default operation limit is for generated streams; a trace is replayed to its end
+    if (!config.trace_path.empty() && !ops_given) {
+        config.num_operations = 0;
+    }
+    if (config.num_operations == 0 && config.seconds <= 0 && config.trace_path.empty()) {
+        cerr << "An unbounded generated stream needs --seconds\n";
+        return false;
+    }
+    return true;
+}
+
+/* ******************************************************************************************** *
+ *   OPERATION SOURCES
+ * ******************************************************************************************** */
+
+// Unbounded version of the experiment workload: each operation's type is drawn from the mix,
+// insertions get fresh IDs and random keys, deletions target the key of a random earlier
+// insertion and searches look for random keys. Uses the same Philox streams as
+// ParallelOpGenerator, so a seed always gives the same stream.
+class GeneratedOpSource {
+   private:
+    Philox philox;
+    const stream_config& config;
+    uint64_t position = 0;
+    uint64_t num_inserted = 0;  // an unbounded stream can pass 2^31 insertions
+
+    int insertion_key(const uint64_t j) const {
+        return (int)philox.below(j, STREAM_INSERTION_KEY, KEY_MAX + 1);
+    }
+
+   public:
+    GeneratedOpSource(const uint64_t seed, const stream_config& config)
+        : philox(seed), config(config) {}
+
+    bool next(packed_op& op) {
+        const int r = (int)philox.below(position, STREAM_SEQUENCE, 100);
+        const bool is_deletion =
+            r >= config.insert_pct && r < config.insert_pct + config.delete_pct;
+        if (r < config.insert_pct || (is_deletion && num_inserted == 0)) {
+            // IDs are ints, so they wrap after 2^31 insertions; keys keep their own counter
+            op = {OPTYPE_INSERTION, {(int)(num_inserted + 1), insertion_key(num_inserted)}};
+            num_inserted++;
+        } else if (is_deletion) {
+            // below() takes a 32-bit bound; past that, modulo bias is under 2^-32
+            const uint64_t target =
+                num_inserted <= UINT32_MAX
+                    ? philox.below(position, STREAM_DELETION_TARGET, (uint32_t)num_inserted)
+                    : philox.u64(position, STREAM_DELETION_TARGET) % num_inserted;
+            op = {OPTYPE_DELETION, {0, insertion_key(target)}};
+        } else {
+            const int key = (int)philox.below(position, STREAM_SEARCH_KEY, KEY_MAX + 1);
+            op = {OPTYPE_SEARCH, {0, key}};
+        }
+        position++;
+        return true;
+    }
+};
+
+/* ******************************************************************************************** *
+ *   PIPELINE
+ * ******************************************************************************************** */
+
+static volatile int stream_sink;  // keeps search results observable
+
+// Producer: push operations from `source` until it ends, the operation limit is reached or time
+// runs out, then raise `done`
+template <class Source>
+static void produce(Source& source, const stream_config& config, SpscRing<stream_item>& ring,
+                    atomic<bool>& done, uint64_t& stalls) {
+    const uint64_t deadline =
+        config.seconds > 0 ? steady_now_ns() + (uint64_t)(config.seconds * 1e9) : UINT64_MAX;
+    stream_item item;
+    for (uint64_t i = 0; config.num_operations == 0 || i < config.num_operations; i++) {
+        if ((i & 1023) == 0 && steady_now_ns() >= deadline) {
+            break;
+        }
+        if (!source.next(item.op)) {
+            break;
+        }
+        item.enqueue_tsc = read_tsc();
+        while (!ring.try_push(item)) {
+            stalls++;
+            this_thread::yield();
+        }
+    }
+    done.store(true, memory_order_release);
+}
+
+// Consumer: apply operations to ds until the producer is done and the ring is drained
+template <class DataStructure>
+static void consume(DataStructure& ds, SpscRing<stream_item>& ring, atomic<bool>& done,
+                    stream_result& r) {
+    stream_item item;
+    int hits = 0;
+    while (true) {
+        if (!ring.try_pop(item)) {
+            if (!done.load(memory_order_acquire)) {
+                r.consumer_idles++;
+                this_thread::yield();
+                continue;
+            }
+            // The producer has finished: everything it pushed is visible now
+            if (!ring.try_pop(item)) {
+                break;
+            }
+        }
+        r.queue_delay.record(read_tsc() - item.enqueue_tsc);
+        hits += apply_op(ds, item.op);
+        r.num_operations++;
+    }
+    stream_sink = hits;
+}
+
+template <class DataStructure, class Source>
+static void run_pipeline(Source& source, const stream_config& config, stream_result& r) {
+    DataStructure ds;
+    SpscRing<stream_item> ring(config.ring_capacity);
+    atomic<bool> done(false);
+
+    const uint64_t start = steady_now_ns();  // Start timer
+    thread producer([&source, &config, &ring, &done, &r]() {
+        produce(source, config, ring, done, r.producer_stalls);
+    });
+    consume(ds, ring, done, r);
+    producer.join();
+    settle_engine(ds);
+    const uint64_t end = steady_now_ns();  // Stop timer
+
+    r.seconds = (end - start) / 1e9;
+    r.final_size = ds.size();
+    r.bytes_allocated = ds.bytes_allocated();
+    r.bytes_live = ds.bytes_live();
+}
+
+// Stream into the engine registered under config.engine
+template <class Source>
+static void run_engine(Source& source, const stream_config& config, stream_result& r) {
+    for_each_engine([&source, &config, &r](auto tag, const engine_info& info) {
+        typedef typename decltype(tag)::type Engine;
+        if (config.engine == info.name) {
+            run_pipeline<Engine>(source, config, r);
+        }
+    });
+}
+
+/* ******************************************************************************************** *
+ *   DRIVER
+ * ******************************************************************************************** */
+
+static void print_stream_result(const stream_config& config, const stream_result& r) {
+    const double ticks_per_ns = tsc_ticks_per_ns();
+    cout << "Streamed " << r.num_operations << " operations into " << config.engine << " in "
+         << r.seconds << "s: throughput=" << (r.seconds > 0 ? r.num_operations / r.seconds : 0)
+         << " ops/s producer_stalls=" << r.producer_stalls
+         << " consumer_idles=" << r.consumer_idles << '\n';
+    cout << "Queueing delay (ns): p50=" << r.queue_delay.percentile(50) / ticks_per_ns
+         << " p99=" << r.queue_delay.percentile(99) / ticks_per_ns
+         << " p99.9=" << r.queue_delay.percentile(99.9) / ticks_per_ns
+         << " max=" << r.queue_delay.max_recorded() / ticks_per_ns << '\n';
+    print_footprint(config.engine, r.final_size, r.bytes_allocated, r.bytes_live);
+    print_process_memory("stream");
+}
+
+int run_stream(int argc, char** argv) {
+    stream_config config;
+    if (!parse_stream_args(argc, argv, config)) {
+        return 1;
+    }
+
+    stream_result* r = new stream_result();  // the histogram is too big to want on the stack
+    if (config.trace_path.empty()) {
+        const uint64_t seed = config.seed != 0 ? config.seed : rng.rand_seed();
+        cout << "Workload seed: " << seed << '\n';
+        GeneratedOpSource source(seed, config);
+        run_engine(source, config, *r);
+    } else {
+        TraceReader reader;
+        if (!reader.open(config.trace_path.c_str())) {
+            delete r;
+            return 1;
+        }
+        run_engine(reader, config, *r);
+    }
+    print_stream_result(config, *r);
+    delete r;
+    return 0;
+}
@@ -0,0 +1,52 @@
+#ifndef STREAMING_H
+#define STREAMING_H
+
+#include <cstdint>
+#include <string>
+
+#include "engines.h"
+#include "latency_histogram.h"
+#include "spsc_ring.h"
+#include "timing.h"
+#include "trace.h"
+
+#define STREAM_DEFAULT_RING 65536
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   STREAMING PIPELINE CONFIGURATION
+ *
+ *   A producer thread generates operations (or reads them from a trace) and pushes them through
+ *   a bounded SpscRing to the consumer thread, which applies them to one data structure. Nothing
+ *   is materialised up front, so the stream can be as long as wanted.
+ * ******************************************************************************************** */
+
+struct stream_config {
+    string engine = "treap";  // any engine name in the registry (engines.h)
+    string trace_path;        // empty => generate operations
+    uint64_t num_operations = 1000000;  // 0 => until `seconds` have passed (or the trace ends);
+                                        // a trace runs to its end unless --ops is given
+    double seconds = 0;                 // 0 => no time limit
+    size_t ring_capacity = STREAM_DEFAULT_RING;
+    int insert_pct = 90;  // generated operation mix
+    int delete_pct = 5;
+    int search_pct = 5;
+    uint64_t seed = 0;  // 0 => random
+};
+
+struct stream_result {
+    uint64_t num_operations;
+    double seconds;             // first push to last operation applied
+    uint64_t producer_stalls;   // pushes retried because the ring was full
+    uint64_t consumer_idles;    // pops retried because the ring was empty
+    LatencyHistogram queue_delay;  // TSC ticks from push to pop, per operation
+    size_t final_size;
+    size_t bytes_allocated;
+    size_t bytes_live;
+};
+
+bool parse_stream_args(int argc, char** argv, stream_config& config);
+int run_stream(int argc, char** argv);
+
+#endif  // STREAMING_H
@@ -0,0 +1,52 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <chrono>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define HAVE_TSC 1
+#else
+#define HAVE_TSC 0
+#endif
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   LOW-OVERHEAD TIMERS
+ * ******************************************************************************************** */
+
+typedef chrono::steady_clock steady;
+
+inline uint64_t steady_now_ns() {
+    return chrono::duration_cast<chrono::nanoseconds>(steady::now().time_since_epoch()).count();
+}
+
+// Raw cycle counter. Falls back to steady_clock nanoseconds where there is no TSC.
+inline uint64_t read_tsc() {
+#if HAVE_TSC
+    return __rdtsc();
+#else
+    return steady_now_ns();
+#endif
+}
+
+// Measure TSC ticks per nanosecond against steady_clock over ~10ms
+inline double calibrate_tsc() {
+    const uint64_t start_ns = steady_now_ns();
+    const uint64_t start_tsc = read_tsc();
+    while (steady_now_ns() - start_ns < 10000000) {
+    }
+    const uint64_t end_tsc = read_tsc();
+    const uint64_t end_ns = steady_now_ns();
+    return (double)(end_tsc - start_tsc) / (double)(end_ns - start_ns);
+}
+
+// Calibrated once per process
+inline double tsc_ticks_per_ns() {
+    static const double ticks_per_ns = calibrate_tsc();
+    return ticks_per_ns;
+}
+
+#endif  // TIMING_H
@@ -0,0 +1,273 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include "engines.h"
+#include "rand_int_generator.h"
+
+#define TRACE_MAGIC 0x43415254  // "TRAC" in little-endian
+#define TRACE_VERSION 1
+
+// Trace flags
+#define TRACE_FIXED 0   // 9-byte records: type, key, id
+#define TRACE_VARINT 1  // varint records: type packed with the key delta, then the id delta
+
+#define TRACE_TYPE_BITS 3  // room for more op types than OPTYPE_MAX
+#define TRACE_TYPE_MASK ((1u << TRACE_TYPE_BITS) - 1)
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   BINARY OPERATION TRACE FORMAT
+ *
+ *   [trace_header][record * num_ops]
+ *
+ *   TRACE_FIXED:  uint8 type | int32 key | int32 id
+ *   TRACE_VARINT: varint((zigzag(key - prev_key) << TRACE_TYPE_BITS) | type) |
+ *                 varint(zigzag(id - prev_id))   (insertions only)
+ *                 varint(id)                      (range scans: the span, not an ID)
+ *
+ *   Keys are delta-encoded against the previous record and IDs against the previous insertion,
+ *   so the sequential IDs produced by DataGenerator cost one byte each.
+ * ******************************************************************************************** */
+
+struct trace_header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t num_ops;
+};
+
+inline uint64_t zigzag_encode(const int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+
+inline int64_t zigzag_decode(const uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+/* ******************************************************************************************** *
+ *   RECORDER
+ * ******************************************************************************************** */
+
+class TraceWriter {
+   private:
+    FILE* file = NULL;
+    trace_header header;
+    int prev_key = 0;
+    int prev_id = 0;
+
+    void put_varint(uint64_t v) {
+        while (v >= 0x80) {
+            fputc((int)(v & 0x7f) | 0x80, file);
+            v >>= 7;
+        }
+        fputc((int)v, file);
+    }
+
+   public:
+    TraceWriter() {}
+    ~TraceWriter() { close(); }
+
+    TraceWriter(const TraceWriter&) = delete;
+    TraceWriter& operator=(const TraceWriter&) = delete;
+
+    bool open(const char* path, const uint32_t flags) {
+        close();
+        file = fopen(path, "wb");
+        if (file == NULL) {
+            cerr << "Failed to open trace " << path << " for writing\n";
+            return false;
+        }
+        setvbuf(file, NULL, _IOFBF, 1 << 20);
+        header = {TRACE_MAGIC, TRACE_VERSION, flags, 0, 0};
+        prev_key = 0;
+        prev_id = 0;
+        return fwrite(&header, sizeof(header), 1, file) == 1;
+    }
+
+    void record(const packed_op& op) {
+        if (header.flags & TRACE_VARINT) {
+            const uint64_t key_delta = zigzag_encode((int64_t)op.ELEM.KEY - prev_key);
+            put_varint((key_delta << TRACE_TYPE_BITS) | (uint64_t)op.TYPE);
+            prev_key = op.ELEM.KEY;
+            if (op.TYPE == OPTYPE_INSERTION) {
+                put_varint(zigzag_encode((int64_t)op.ELEM.ID - prev_id));
+                prev_id = op.ELEM.ID;
+            } else if (op.TYPE == OPTYPE_RANGE) {
+                put_varint((uint64_t)(uint32_t)op.ELEM.ID);
+            }
+        } else {
+            const uint8_t type = (uint8_t)op.TYPE;
+            fwrite(&type, sizeof(type), 1, file);
+            fwrite(&op.ELEM.KEY, sizeof(int), 1, file);
+            fwrite(&op.ELEM.ID, sizeof(int), 1, file);
+        }
+        header.num_ops++;
+    }
+
+    // Patch the final op count into the header and flush. Returns false if any write failed.
+    bool close() {
+        if (file == NULL) {
+            return true;
+        }
+        bool ok = !ferror(file) && fseek(file, 0, SEEK_SET) == 0 &&
+                  fwrite(&header, sizeof(header), 1, file) == 1;
+        ok = (fclose(file) == 0) && ok;
+        file = NULL;
+        if (!ok) {
+            cerr << "Failed to write trace\n";
+        }
+        return ok;
+    }
+};
+
+/* ******************************************************************************************** *
+ *   STREAMING REPLAYER
+ * ******************************************************************************************** */
+
+// Decodes a trace straight out of an mmap, one record at a time, so replaying never holds
+// the decoded operations in memory.
+class TraceReader {
+   private:
+    void* base = MAP_FAILED;
+    size_t length = 0;
+    trace_header header;
+    const uint8_t* pos = NULL;
+    const uint8_t* end = NULL;
+    uint64_t ops_read = 0;
+    int prev_key = 0;
+    int prev_id = 0;
+
+    bool get_varint(uint64_t& v) {
+        v = 0;
+        for (int shift = 0; pos < end && shift < 64; shift += 7) {
+            const uint8_t byte = *pos++;
+            v |= (uint64_t)(byte & 0x7f) << shift;
+            if ((byte & 0x80) == 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+   public:
+    TraceReader() {}
+    ~TraceReader() { close(); }
+
+    TraceReader(const TraceReader&) = delete;
+    TraceReader& operator=(const TraceReader&) = delete;
+
+    bool open(const char* path) {
+        close();
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) {
+            cerr << "Failed to open trace " << path << '\n';
+            return false;
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(trace_header)) {
+            cerr << "Trace " << path << " is truncated\n";
+            ::close(fd);
+            return false;
+        }
+        length = st.st_size;
+        base = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (base == MAP_FAILED) {
+            cerr << "Failed to mmap trace " << path << '\n';
+            length = 0;
+            return false;
+        }
+        madvise(base, length, MADV_SEQUENTIAL);
+
+        header = *(const trace_header*)base;
+        if (header.magic != TRACE_MAGIC || header.version != TRACE_VERSION) {
+            cerr << "Trace " << path << " has an unsupported format\n";
+            close();
+            return false;
+        }
+        rewind();
+        return true;
+    }
+
+    void close() {
+        if (base != MAP_FAILED) {
+            munmap(base, length);
+        }
+        base = MAP_FAILED;
+        length = 0;
+        pos = NULL;
+        end = NULL;
+    }
+
+    void rewind() {
+        pos = (const uint8_t*)base + sizeof(trace_header);
+        end = (const uint8_t*)base + length;
+        ops_read = 0;
+        prev_key = 0;
+        prev_id = 0;
+    }
+
+    uint64_t size() const { return header.num_ops; }
+
+    // Decode the next operation. Returns false at the end of the trace (or on a corrupt record).
+    bool next(packed_op& op) {
+        if (ops_read == header.num_ops) {
+            return false;
+        }
+        if (header.flags & TRACE_VARINT) {
+            uint64_t v;
+            if (!get_varint(v)) {
+                return false;
+            }
+            op.TYPE = (int)(v & TRACE_TYPE_MASK);
+            op.ELEM.KEY = prev_key = (int)(prev_key + zigzag_decode(v >> TRACE_TYPE_BITS));
+            op.ELEM.ID = 0;
+            if (op.TYPE == OPTYPE_INSERTION) {
+                if (!get_varint(v)) {
+                    return false;
+                }
+                op.ELEM.ID = prev_id = (int)(prev_id + zigzag_decode(v));
+            } else if (op.TYPE == OPTYPE_RANGE) {
+                if (!get_varint(v)) {
+                    return false;
+                }
+                op.ELEM.ID = (int)v;
+            }
+        } else {
+            if (end - pos < 9) {
+                return false;
+            }
+            op.TYPE = *pos;
+            memcpy(&op.ELEM.KEY, pos + 1, sizeof(int));
+            memcpy(&op.ELEM.ID, pos + 5, sizeof(int));
+            pos += 9;
+        }
+        ops_read++;
+        return true;
+    }
+};
+
+// Apply every operation in the trace to an engine (see engines.h). Returns the number of
+// operations applied; `hits` counts search hits and range-scanned elements.
+template <class Engine>
+uint64_t replay_trace(TraceReader& reader, Engine& ds, int& hits) {
+    packed_op op;
+    uint64_t count = 0;
+    hits = 0;
+    reader.rewind();
+    while (reader.next(op)) {
+        hits += apply_op(ds, op);
+        count++;
+    }
+    return count;
+}
+
+#endif  // TRACE_H
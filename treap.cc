@@ -1,161 +1,357 @@
-/* ******************************************************************************************** *
- * COMP90077 Advanced Algorithms and Data Structures: Assignment 2
- *  Title: An Experimental Study on Treaps
- *  Author: Michael Manoussakis
- *  Date: 03/07/2023
- * ******************************************************************************************** */
-
-#include <cassert>
-#include <chrono>
-#include <ctime>
-#include <iterator>
-#include <vector>
-
-#include "experiments.h"
-
-#define ALL_EXPERIMENTS -1
-
-using namespace std;
-
-typedef chrono::system_clock csc;
-
-/* ******************************************************************************************** *
- *   TESTS
- * ******************************************************************************************** */
-
-void sanity_test_1() {
-    csc::time_point start = csc::now();  // Start timer
-
-    DataGenerator dg;
-
-    cout << "Initialise element\n";
-    element t = dg.gen_element();
-
-    cout << "Initialise insertion\n";
-    insertion_op e1 = dg.gen_insertion();
-    cout << "Initialise deletion\n";
-    deletion_op e2 = dg.gen_deletion();
-    cout << "Initialise search\n";
-    search_op e3 = dg.gen_search();
-
-    csc::time_point end = csc::now();  // Stop timer
-    print_time(start, end, "Sanity Test 1");
-}
-
-void sanity_test_2() {
-
-    csc::time_point start = csc::now();  // Start timer
-
-    cout << "Initialise Data Structures\n";
-    DataGenerator dg;
-    DynamicArray dyn_array;
-    RandomisedTreap r_treap;
-
-    cout << "Create 10 insertions\n";
-    insertion_op insert1k[10] = {};
-    for (int i = 0; i < 10; i++) {
-        insert1k[i] = dg.gen_insertion();
-    }
-
-    cout << "10 insertions into DynamicArray\n";
-    for (int i = 0; i < 10; i++) {
-        dyn_array.insert(insert1k[i].ELEM);
-    }
-
-    cout << "10 insertions into RandomisedTreap\n";
-    for (int i = 0; i < 10; i++) {
-        r_treap.insert(insert1k[i].ELEM);
-    }
-
-    cout << "print DynamicArray\n";
-    dyn_array.print();
-
-    cout << "print RandomisedTreap\n";
-    r_treap.print();
-
-    cout << "5 searches in RandomisedTreap\n";
-    for (int i = 0; i < 5; i++) {
-        search_op s = dg.gen_search();
-        cout << "searching key=" << s.KEY;
-        element* e = r_treap.search(s.KEY);
-        if (e == NULL) {
-            cout << "=> not found\n";
-        } else {
-            cout << "=> found elem=(" << e->ID << ", " << e->KEY << ")\n";
-        }
-    }
-
-    cout << "5 deletions from RandomisedTreap\n";
-    for (int i = 0; i < 5; i++) {
-        deletion_op d = dg.gen_deletion();
-        cout << "deleting key=" << d.KEY << '\n';
-        r_treap.delet(d.KEY);
-    }
-
-    cout << "print RandomisedTreap\n";
-    r_treap.print();
-
-    cout << "Treap height = " << r_treap.get_height() << "\n";
-    int* depths = r_treap.get_all_node_depths(10);
-    cout << "Avg node depth = [";
-    for (int i = 0; i < 10; i++) {
-        cout << depths[i] << ",";
-    }
-    cout << "]\n";
-    free(depths);
-
-    csc::time_point end = csc::now();  // Stop timer
-    print_time(start, end, "Sanity Test");
-}
-
-/* ******************************************************************************************** *
- *   MAIN
- * ******************************************************************************************** */
-
-int main(int argc, char** argv) {
-    if (argc > 2) {
-        cout << "Too many arguments.";
-        return 1;
-    }
-
-    int experiment_num = ALL_EXPERIMENTS;
-
-    if (argc > 1) {
-        experiment_num = atoi(argv[1]);
-
-        if (experiment_num < 0 || experiment_num > 4) {
-            cout << "Invalid experiment number. Expected 0-4.";
-            return 1;
-        }
-    }
-
-    cout << "==Sanity Test==\n";
-    sanity_test_1();
-    sanity_test_2();
-
-    switch (experiment_num) {
-        case ALL_EXPERIMENTS:
-            experiment0();
-            experiment1();
-            experiment2();
-            experiment3();
-            experiment4();
-            break;
-        case 0:
-            experiment0();
-            break;
-        case 1:
-            experiment1();
-            break;
-        case 2:
-            experiment2();
-            break;
-        case 3:
-            experiment3();
-            break;
-        case 4:
-            experiment4();
-            break;
-    }
-    return 0;
-}
+/* ******************************************************************************************** *
+ * COMP90077 Advanced Algorithms and Data Structures: Assignment 2
+ *  Title: An Experimental Study on Treaps
+ *  Author: Michael Manoussakis
+ *  Date: 03/07/2023
+ * ******************************************************************************************** */
+
+#include <cassert>
+#include <cstddef>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <iterator>
+#include <vector>
+
+#include "benchmark.h"
+#include "experiments.h"
+#include "streaming.h"
+
+#define ALL_EXPERIMENTS -1
+
+using namespace std;
+
+typedef chrono::system_clock csc;
+
+/* ******************************************************************************************** *
+ *   TESTS
+ * ******************************************************************************************** */
+
+void sanity_test_1() {
+    csc::time_point start = csc::now();  // Start timer
+
+    DataGenerator dg;
+
+    cout << "Initialise element\n";
+    element t = dg.gen_element();
+    cout << "elem=(" << t.ID << ", " << t.KEY << ")\n";
+
+    cout << "Initialise insertion\n";
+    insertion_op e1 = dg.gen_insertion();
+    cout << "insert elem=(" << e1.ELEM.ID << ", " << e1.ELEM.KEY << ")\n";
+    cout << "Initialise deletion\n";
+    deletion_op e2 = dg.gen_deletion();
+    cout << "delete key=" << e2.KEY << '\n';
+    cout << "Initialise search\n";
+    search_op e3 = dg.gen_search();
+    cout << "search key=" << e3.KEY << '\n';
+
+    csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, "Sanity Test 1");
+}
+
+void sanity_test_2() {
+
+    csc::time_point start = csc::now();  // Start timer
+
+    cout << "Initialise Data Structures\n";
+    DataGenerator dg;
+    DynamicArray dyn_array;
+    RandomisedTreap r_treap;
+
+    cout << "Create 10 insertions\n";
+    insertion_op insert1k[10] = {};
+    for (int i = 0; i < 10; i++) {
+        insert1k[i] = dg.gen_insertion();
+    }
+
+    cout << "10 insertions into DynamicArray\n";
+    for (int i = 0; i < 10; i++) {
+        dyn_array.insert(insert1k[i].ELEM);
+    }
+
+    cout << "10 insertions into RandomisedTreap\n";
+    for (int i = 0; i < 10; i++) {
+        r_treap.insert(insert1k[i].ELEM);
+    }
+
+    cout << "print DynamicArray\n";
+    dyn_array.print();
+
+    cout << "print RandomisedTreap\n";
+    r_treap.print();
+
+    cout << "5 searches in RandomisedTreap\n";
+    for (int i = 0; i < 5; i++) {
+        search_op s = dg.gen_search();
+        cout << "searching key=" << s.KEY;
+        element* e = r_treap.search(s.KEY);
+        if (e == NULL) {
+            cout << "=> not found\n";
+        } else {
+            cout << "=> found elem=(" << e->ID << ", " << e->KEY << ")\n";
+        }
+    }
+
+    cout << "5 deletions from RandomisedTreap\n";
+    for (int i = 0; i < 5; i++) {
+        deletion_op d = dg.gen_deletion();
+        cout << "deleting key=" << d.KEY << '\n';
+        r_treap.delet(d.KEY);
+    }
+
+    cout << "print RandomisedTreap\n";
+    r_treap.print();
+
+    cout << "Treap height = " << r_treap.get_height() << "\n";
+    int* depths = r_treap.get_all_node_depths(10);
+    cout << "Avg node depth = [";
+    for (int i = 0; i < 10; i++) {
+        cout << depths[i] << ",";
+    }
+    cout << "]\n";
+    free(depths);
+
+    csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, "Sanity Test");
+}
+
+void sanity_test_3() {
+    csc::time_point start = csc::now();  // Start timer
+
+    cout << "Initialise RandomisedTreap in deadline mode\n";
+    DataGenerator dg;
+    RandomisedTreap r_treap;
+
+    cout << "10 insertions with expiry times 10, 20, ..., 100 in shuffled order\n";
+    int expiries[10];
+    for (int i = 0; i < 10; i++) {
+        expiries[i] = (i + 1) * 10;
+    }
+    rng.shuffle(expiries, expiries + 10);
+    element elems[10];
+    for (int i = 0; i < 10; i++) {
+        elems[i] = dg.gen_element();
+        r_treap.insert(elems[i], expiries[i]);
+    }
+    cout << "min expiry = " << r_treap.peek_min_priority() << '\n';
+    assert(("Expected min expiry 10", r_treap.peek_min_priority() == 10));
+
+    cout << "extend key=" << elems[0].KEY << " to expire at 1000\n";
+    const bool updated = r_treap.update_priority(elems[0].KEY, 1000);
+    assert(("Update of a present key failed", updated));
+
+    vector<element> expired;
+    const int num_expired = r_treap.pop_expired(45, &expired);
+    cout << "expired at 45: " << num_expired << " elements\n";
+    int num_due = 0;
+    for (int i = 1; i < 10; i++) {
+        num_due += expiries[i] <= 45;
+    }
+    assert(("Expected every element due by 45 to expire", num_expired == num_due));
+    assert(("Unexpired element left due", r_treap.peek_min_priority() > 45));
+    assert(("Removed elements not all returned", (int)expired.size() == num_expired));
+    assert(("Deadline mode broke the treap", r_treap.validate().ok()));
+
+    csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, "Sanity Test 3");
+}
+
+void sanity_test_4() {
+    csc::time_point start = csc::now();  // Start timer
+
+    cout << "Initialise RandomisedTreap with lazy deletion and adaptive priorities\n";
+    RandomisedTreap r_treap;
+    r_treap.set_lazy_delete(100.0);  // never purge: tombstones stay in the tree
+    r_treap.set_adaptive(1);         // every found search may promote its node
+
+    cout << "200 insertions over 5 keys\n";
+    for (int i = 0; i < 200; i++) {
+        element e = {i, i % 5};
+        r_treap.insert(e);
+    }
+
+    cout << "delete, reprioritise and search each key 30 times\n";
+    for (int round = 0; round < 30; round++) {
+        for (int key = 0; key < 5; key++) {
+            r_treap.delet(key);
+            const bool updated = r_treap.update_priority(key, rng.rand_priority());
+            assert(("Update of a present key failed", updated));
+            assert(("Present key not found", r_treap.search(key) != NULL));
+        }
+    }
+    cout << "tombstones = " << r_treap.tombstones() << ", size = " << r_treap.size() << '\n';
+    assert(("Expected 50 live elements", r_treap.size() == 50));
+    assert(("Lazy deletion with duplicates broke the treap", r_treap.validate().ok()));
+
+    csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, "Sanity Test 4");
+}
+
+void sanity_test_5() {
+    const char* SNAPSHOT_PATH = "sanity_snapshot.bin";
+    csc::time_point start = csc::now();  // Start timer
+
+    cout << "Initialise RandomisedTreap with 1000 elements\n";
+    DataGenerator dg;
+    RandomisedTreap r_treap;
+    element elems[1000];
+    for (int i = 0; i < 1000; i++) {
+        elems[i] = dg.gen_element();
+        r_treap.insert(elems[i]);
+    }
+
+    cout << "save, map and search the snapshot\n";
+    const bool saved = r_treap.save(SNAPSHOT_PATH);
+    assert(("Snapshot save failed", saved));
+    MappedTreap mapped;
+    const bool opened = mapped.open_mapped(SNAPSHOT_PATH);
+    assert(("Snapshot open failed", opened));
+    assert(("Snapshot size differs", mapped.size() == 1000));
+    assert(("Snapshot links invalid", mapped.validate()));
+    for (int i = 0; i < 1000; i++) {
+        const element* e = mapped.search(elems[i].KEY);
+        assert(("Saved key not found in snapshot", e != NULL && e->KEY == elems[i].KEY));
+    }
+
+    cout << "thaw the snapshot\n";
+    RandomisedTreap thawed;
+    thawed.thaw(mapped);
+    mapped.close();
+    assert(("Thawed treap invalid", thawed.validate().ok()));
+    assert(("Thawed treap size differs", thawed.size() == 1000));
+
+    cout << "corrupt a right index and validate\n";
+    FILE* f = fopen(SNAPSHOT_PATH, "r+b");
+    assert(("Snapshot reopen failed", f != NULL));
+    const uint32_t bad_links = 1000u << 1;  // right child past the last node
+    fseek(f, sizeof(snapshot_header) + offsetof(snapshot_node, links), SEEK_SET);
+    fwrite(&bad_links, sizeof(bad_links), 1, f);
+    fclose(f);
+    const bool reopened = mapped.open_mapped(SNAPSHOT_PATH);
+    assert(("Snapshot open failed", reopened));
+    assert(("Corrupt snapshot accepted", !mapped.validate()));
+    mapped.close();
+    remove(SNAPSHOT_PATH);
+
+    csc::time_point end = csc::now();  // Stop timer
+    print_time(start, end, "Sanity Test 5");
+}
+
+/* ******************************************************************************************** *
+ *   MAIN
+ * ******************************************************************************************** */
+
+int main(int argc, char** argv) {
+    // ./treap.exe record <path> <num_operations>: record an experiment 4 style trace
+    if (argc > 1 && strcmp(argv[1], "record") == 0) {
+        if (argc != 4 || atoi(argv[3]) < 20) {
+            cout << "Usage: record <path> <num_operations (>= 20)>";
+            return 1;
+        }
+        const int num_operations = atoi(argv[3]);
+        const int num_deletions = num_operations / 20;  // 5% Deletion, 5% Search
+        const int num_searches = num_operations / 20;
+        const int num_insertions = num_operations - num_deletions - num_searches;
+        return record_trace(argv[2], num_operations, num_insertions, num_deletions, num_searches)
+                   ? 0
+                   : 1;
+    }
+    // ./treap.exe replay <path>: replay a recorded trace against every engine
+    if (argc > 1 && strcmp(argv[1], "replay") == 0) {
+        if (argc != 3) {
+            cout << "Usage: replay <path>";
+            return 1;
+        }
+        return replay_trace_file(argv[2]) ? 0 : 1;
+    }
+
+    // ./treap.exe bench [--key=value ...]: configurable benchmark sweep, see benchmark.cc
+    if (argc > 1 && strcmp(argv[1], "bench") == 0) {
+        return run_benchmark(argc - 2, argv + 2);
+    }
+
+    // ./treap.exe stream [--key=value ...]: producer/consumer streaming run, see streaming.cc
+    if (argc > 1 && strcmp(argv[1], "stream") == 0) {
+        return run_stream(argc - 2, argv + 2);
+    }
+
+    // ./treap.exe [experiment] [--jobs=N] [--pin] [--seed=N]: trial runner settings
+    int experiment_num = ALL_EXPERIMENTS;
+    trial_config trials;
+    bool have_experiment = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--jobs=", 7) == 0) {
+            trials.jobs = atoi(argv[i] + 7);
+        } else if (strcmp(argv[i], "--pin") == 0) {
+            trials.pin = true;
+        } else if (strncmp(argv[i], "--seed=", 7) == 0) {
+            trials.seed = strtoull(argv[i] + 7, NULL, 10);
+        } else if (!have_experiment) {
+            experiment_num = atoi(argv[i]);
+            have_experiment = true;
+
+            if (experiment_num < 0 || experiment_num > 9) {
+                cout << "Invalid experiment number. Expected 0-9.";
+                return 1;
+            }
+        } else {
+            cout << "Too many arguments.";
+            return 1;
+        }
+    }
+    configure_trials(trials);
+
+    cout << "==Sanity Test==\n";
+    sanity_test_1();
+    sanity_test_2();
+    sanity_test_3();
+    sanity_test_4();
+    sanity_test_5();
+
+    switch (experiment_num) {
+        case ALL_EXPERIMENTS:
+            experiment0();
+            experiment1();
+            experiment2();
+            experiment3();
+            experiment4();
+            experiment5();
+            experiment6();
+            experiment7();
+            experiment8();
+            experiment9();
+            break;
+        case 0:
+            experiment0();
+            break;
+        case 1:
+            experiment1();
+            break;
+        case 2:
+            experiment2();
+            break;
+        case 3:
+            experiment3();
+            break;
+        case 4:
+            experiment4();
+            break;
+        case 5:
+            experiment5();
+            break;
+        case 6:
+            experiment6();
+            break;
+        case 7:
+            experiment7();
+            break;
+        case 8:
+            experiment8();
+            break;
+        case 9:
+            experiment9();
+            break;
+    }
+    return 0;
+}
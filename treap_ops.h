@@ -0,0 +1,185 @@
+#ifndef TREAP_OPS_H
+#define TREAP_OPS_H
+
+#include <cstdlib>
+#include <vector>
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   TREAP NODE OPERATIONS
+ *
+ *   Rotations, insertion, deletion and checks for pointer-based treaps on plain nodes.
+ *   RadixTreapForest and IntervalTreap are built from these alone. RandomisedTreap uses only the
+ *   rotations: its insertion and deletion count comparisons and rotations for TREAP_STATS, break
+ *   priority ties by key and free nodes into its arena, so they stay its own. AvlTree shares
+ *   treap_dealloc().
+ *
+ *   A Node has `priority`, `left`, `right` and get_key(); smaller priorities sit higher and
+ *   duplicate keys go left. A node that keeps a summary of its subtree overloads treap_update(),
+ *   which is called bottom-up wherever a node's children may have changed, and
+ *   treap_node_valid(), which validate checks at every node. Unlinked nodes are handed to the
+ *   caller's release(Node*), so each tree keeps its own allocation and counts.
+ * ******************************************************************************************** */
+
+// Recompute whatever a node summarises about its subtree (nothing by default)
+template <class Node>
+static inline void treap_update(Node*) {}
+
+// Check that summary (nothing to check by default)
+template <class Node>
+static inline bool treap_node_valid(Node*) {
+    return true;
+}
+
+template <class Node>
+static inline Node* treap_rotate_left(Node* head) {
+    Node* temp = head->right;
+    head->right = temp->left;
+    temp->left = head;
+    treap_update(head);
+    treap_update(temp);
+    return temp;
+}
+
+template <class Node>
+static inline Node* treap_rotate_right(Node* head) {
+    Node* temp = head->left;
+    head->left = temp->right;
+    temp->right = head;
+    treap_update(head);
+    treap_update(temp);
+    return temp;
+}
+
+// Core helper function for insertion operation: insert n below head. Returns the new subtree
+// root.
+template <class Node>
+static Node* treap_insert(Node* head, Node* n) {
+    if (head == NULL) {
+        return n;
+    }
+    if (n->get_key() <= head->get_key()) {
+        head->left = treap_insert(head->left, n);
+        if (head->left->priority < head->priority) {
+            return treap_rotate_right(head);
+        }
+    } else {
+        head->right = treap_insert(head->right, n);
+        if (head->right->priority < head->priority) {
+            return treap_rotate_left(head);
+        }
+    }
+    treap_update(head);
+    return head;
+}
+
+// Core helper function for deletion operation: rotate node down past its smaller-priority
+// child until it can be spliced out, then release it. Returns the new subtree root.
+template <class Node, class Release>
+static Node* treap_delete_root(Node* node, Release release) {
+    if (node->left == NULL || node->right == NULL) {
+        Node* child = (node->left != NULL) ? node->left : node->right;
+        release(node);
+        return child;
+    }
+    Node* top;
+    if (node->left->priority < node->right->priority) {
+        top = treap_rotate_right(node);
+        top->right = treap_delete_root(node, release);
+    } else {
+        top = treap_rotate_left(node);
+        top->left = treap_delete_root(node, release);
+    }
+    treap_update(top);
+    return top;
+}
+
+// Core helper function for deletion operation: delete the first node with key on the search
+// path, as a search would find it. Returns the new subtree root.
+template <class Node, class Release>
+static Node* treap_delete_key(Node* head, const int key, Release release) {
+    if (head == NULL) {
+        return NULL;
+    }
+    if (key == head->get_key()) {
+        return treap_delete_root(head, release);
+    }
+    if (key < head->get_key()) {
+        head->left = treap_delete_key(head->left, key, release);
+    } else {
+        head->right = treap_delete_key(head->right, key, release);
+    }
+    treap_update(head);
+    return head;
+}
+
+// Core helper function for range scans: in-order visit(Node*) of keys in [lo, hi]. Equal keys
+// can sit on either side of a node after rotations, so both bounds are inclusive.
+template <class Node, class Visitor>
+static void treap_range(Node* head, const int lo, const int hi, Visitor& visit) {
+    if (head == NULL) {
+        return;
+    }
+    const int key = head->get_key();
+    if (lo <= key) {
+        treap_range(head->left, lo, hi, visit);
+    }
+    if (lo <= key && key <= hi) {
+        visit(head);
+    }
+    if (key <= hi) {
+        treap_range(head->right, lo, hi, visit);
+    }
+}
+
+// Core helper function for validate: BST order within [lo, hi], heap order and each node's
+// summary, counting the nodes reached. Iterative, so a degenerate tree cannot overflow the stack.
+template <class Node>
+static bool treap_valid(Node* head, const int lo, const int hi, size_t& count) {
+    struct frame {
+        Node* node;
+        int lo;  // bounds set by all ancestors
+        int hi;
+    };
+    vector<frame> stack;
+    if (head != NULL) {
+        stack.push_back({head, lo, hi});
+    }
+    while (!stack.empty()) {
+        const frame f = stack.back();
+        stack.pop_back();
+        Node* node = f.node;
+        const int key = node->get_key();
+        count++;
+        if (key < f.lo || f.hi < key || !treap_node_valid(node)) {
+            return false;
+        }
+        if (node->left != NULL) {
+            if (node->left->priority < node->priority) {
+                return false;
+            }
+            stack.push_back({node->left, f.lo, key});
+        }
+        if (node->right != NULL) {
+            if (node->right->priority < node->priority) {
+                return false;
+            }
+            stack.push_back({node->right, key, f.hi});
+        }
+    }
+    return true;
+}
+
+// Delete every node of the subtree
+template <class Node>
+static void treap_dealloc(Node* head) {
+    if (head == NULL) {
+        return;
+    }
+    treap_dealloc(head->left);
+    treap_dealloc(head->right);
+    delete (head);
+}
+
+#endif  // TREAP_OPS_H
@@ -0,0 +1,146 @@
+#ifndef TRIAL_RUNNER_H
+#define TRIAL_RUNNER_H
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "philox.h"
+#include "rand_int_generator.h"
+
+// Philox stream for per-trial seeds (the key is the run's seed)
+#define STREAM_TRIAL_SEED 5
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   TRIAL RUNNER
+ *
+ *   Runs independent trials on a pool of worker threads, or timing-sensitive phases one at a
+ *   time ("isolated"). Before each trial or phase, the running thread's rng is reseeded from
+ *   (run seed, experiment number, trial number), so a trial's random choices do not depend on
+ *   which worker ran it or on how many workers there are, and phase 0 of one experiment does
+ *   not replay the random stream of phase 0 of another. Trials write only to their own
+ *   outputs, which the caller combines in trial order afterwards, so the aggregate is
+ *   deterministic too.
+ * ******************************************************************************************** */
+
+struct trial_config {
+    int jobs = 0;       // worker threads for independent trials; 0 => one per allowed core
+    bool pin = false;   // pin each worker (and isolated phases) to its own core
+    uint64_t seed = 0;  // run seed; 0 => random
+};
+
+class TrialRunner {
+   private:
+    trial_config config;
+    int experiment;  // high half of the seed counter, so experiments draw different streams
+    Philox philox;
+    vector<int> cpus;  // cores this process may run on
+
+    static vector<int> allowed_cpus() {
+        vector<int> allowed;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+            for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+                if (CPU_ISSET(cpu, &set)) {
+                    allowed.push_back(cpu);
+                }
+            }
+        }
+        if (allowed.empty()) {
+            allowed.push_back(0);
+        }
+        return allowed;
+    }
+
+    // Pin the calling thread to one core. Returns false (and leaves it unpinned) on failure.
+    static bool pin_to(const int cpu) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+    }
+
+    static trial_config resolve_seed(trial_config config) {
+        if (config.seed == 0) {
+            config.seed = rng.rand_seed();
+        }
+        return config;
+    }
+
+    void seed_trial(const int trial) {
+        const uint64_t counter = ((uint64_t)(uint32_t)experiment << 32) | (uint32_t)trial;
+        rng.seed(philox.u64(counter, STREAM_TRIAL_SEED));
+    }
+
+   public:
+    TrialRunner(const trial_config& config, const int experiment)
+        : config(resolve_seed(config)),
+          experiment(experiment),
+          philox(this->config.seed),
+          cpus(allowed_cpus()) {}
+
+    uint64_t get_seed() const { return config.seed; }
+
+    int num_workers(const int num_trials) const {
+        const int jobs = config.jobs > 0 ? config.jobs : (int)cpus.size();
+        return max(1, min(jobs, num_trials));
+    }
+
+    // Pin the calling thread, worker w of a pool or of a multithreaded phase, to its own core
+    // if pinning is on. Threads started by an isolated phase inherit its single core, so they
+    // must call this to spread out.
+    void pin_worker(const int w) {
+        if (config.pin && !pin_to(cpus[w % cpus.size()])) {
+            cerr << "Failed to pin worker " << w << ", running unpinned\n";
+        }
+    }
+
+    // Run trial(i) for every i in [0, num_trials), spread over the worker pool
+    template <class Trial>
+    void run_parallel(const int num_trials, Trial trial) {
+        atomic<int> next_trial(0);
+        const int workers = num_workers(num_trials);
+        vector<thread> threads;
+        for (int w = 0; w < workers; w++) {
+            threads.push_back(thread([this, w, num_trials, &next_trial, &trial]() {
+                pin_worker(w);
+                for (int i = next_trial++; i < num_trials; i = next_trial++) {
+                    seed_trial(i);
+                    trial(i);
+                }
+            }));
+        }
+        for (size_t w = 0; w < threads.size(); w++) {
+            threads[w].join();
+        }
+    }
+
+    // Run a timing-sensitive phase with nothing else from this runner alongside it: on its own
+    // pinned thread if pinning is on, otherwise on the calling thread
+    template <class Phase>
+    void run_isolated(const int phase_id, Phase phase) {
+        if (!config.pin) {
+            seed_trial(phase_id);
+            phase();
+            return;
+        }
+        thread worker([this, phase_id, &phase]() {
+            if (!pin_to(cpus[0])) {
+                cerr << "Failed to pin phase " << phase_id << ", running unpinned\n";
+            }
+            seed_trial(phase_id);
+            phase();
+        });
+        worker.join();
+    }
+};
+
+#endif  // TRIAL_RUNNER_H
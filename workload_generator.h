@@ -0,0 +1,278 @@
+#ifndef WORKLOAD_GENERATOR_H
+#define WORKLOAD_GENERATOR_H
+
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "rand_int_generator.h"
+
+// Key distributions
+#define KEYDIST_UNIFORM 0
+#define KEYDIST_ZIPF 1        // skewed popularity; hot keys are scattered over the key space
+#define KEYDIST_SEQUENTIAL 2  // monotonically increasing keys; accesses favour recent keys
+#define KEYDIST_CLUSTERED 3   // keys fall in a few dense ranges
+#define KEYDIST_HOTSPOT 4     // most accesses hit a window of records that moves over time
+
+#define ZIPF_SCRAMBLE 2654435761ULL  // prime, so rank -> key is a bijection mod KEY_MAX + 1
+
+using namespace std;
+
+/* ******************************************************************************************** *
+ *   WORKLOAD SPECIFICATION
+ * ******************************************************************************************** */
+
+// Percentage of each logical operation. An update is a deletion of an existing record followed
+// by an insertion of a new version of it (same key, new ID).
+struct workload_mix {
+    int insert_pct;
+    int delete_pct;
+    int search_pct;
+    int range_pct;
+    int update_pct;
+};
+
+struct workload_spec {
+    int key_dist = KEYDIST_UNIFORM;
+    double zipf_theta = 0.99;
+    int num_clusters = 16;
+    int cluster_width = 10000;  // keys per cluster
+    double hot_fraction = 0.9;  // share of accesses that go to the hot window
+    int hot_width = 1000;       // records in the hot window
+    int hot_move_every = 10000;  // operations between hot window moves
+    int max_scan_span = 1000;    // range scans cover up to this many keys
+    workload_mix mix = {90, 5, 5, 0, 0};
+};
+
+// YCSB core workloads A, B, C and E, in terms of our operation types
+inline bool ycsb_mix(const char preset, workload_mix& mix) {
+    switch (preset) {
+        case 'a':
+        case 'A':
+            mix = {0, 0, 50, 0, 50};  // update heavy
+            return true;
+        case 'b':
+        case 'B':
+            mix = {0, 0, 95, 0, 5};  // read mostly
+            return true;
+        case 'c':
+        case 'C':
+            mix = {0, 0, 100, 0, 0};  // read only
+            return true;
+        case 'e':
+        case 'E':
+            mix = {5, 0, 0, 95, 0};  // short ranges
+            return true;
+    }
+    return false;
+}
+
+inline bool key_dist_from_name(const string& name, int& key_dist) {
+    const char* NAMES[] = {"uniform", "zipf", "sequential", "clustered", "hotspot"};
+    for (int i = 0; i <= KEYDIST_HOTSPOT; i++) {
+        if (name == NAMES[i]) {
+            key_dist = i;
+            return true;
+        }
+    }
+    return false;
+}
+
+/* ******************************************************************************************** *
+ *   ZIPF SAMPLER
+ *
+ *   Rejection-inversion sampling (Hörmann and Derflinger, 1996): draws ranks 1..n with
+ *   P(k) proportional to 1 / k^theta in O(1) expected time and without precomputing the
+ *   normalising constant, so n can change between draws as records are inserted.
+ * ******************************************************************************************** */
+
+class ZipfSampler {
+   private:
+    double theta;
+    double h_integral_x1;
+    double s;
+
+    static double helper1(const double x) {
+        return fabs(x) > 1e-8 ? log1p(x) / x : 1 - x * (0.5 - x * (1.0 / 3 - 0.25 * x));
+    }
+
+    static double helper2(const double x) {
+        return fabs(x) > 1e-8 ? expm1(x) / x : 1 + x * 0.5 * (1 + x * (1.0 / 3) * (1 + 0.25 * x));
+    }
+
+    double h(const double x) const { return exp(-theta * log(x)); }
+
+    double h_integral(const double x) const {
+        const double log_x = log(x);
+        return helper2((1 - theta) * log_x) * log_x;
+    }
+
+    double h_integral_inverse(const double x) const {
+        double t = x * (1 - theta);
+        if (t < -1) {
+            t = -1;  // guard against rounding
+        }
+        return exp(helper1(t) * x);
+    }
+
+   public:
+    explicit ZipfSampler(const double theta = 0.99) : theta(theta) {
+        h_integral_x1 = h_integral(1.5) - 1;
+        s = 2 - h_integral_inverse(h_integral(2.5) - h(2));
+    }
+
+    // Rank in [1, n]
+    int sample(const int n) const {
+        const double h_integral_n = h_integral(n + 0.5);
+        while (true) {
+            const double u = h_integral_n + rng.rand_unit() * (h_integral_x1 - h_integral_n);
+            const double x = h_integral_inverse(u);
+            int k = (int)(x + 0.5);
+            k = max(1, min(k, n));
+            if (k - x <= s || u >= h_integral(k + 0.5) - h(k)) {
+                return k;
+            }
+        }
+    }
+};
+
+/* ******************************************************************************************** *
+ *   WORKLOAD GENERATOR
+ *
+ *   Inserted keys are drawn from the key distribution. Deletions, searches and range scans pick
+ *   one of the records inserted so far according to its popularity under the same distribution,
+ *   so they always target live keys (deleted records are removed from the pool).
+ * ******************************************************************************************** */
+
+class WorkloadGenerator {
+   private:
+    workload_spec spec;
+    ZipfSampler zipf;
+    vector<int> records;  // keys of live records, in insertion order (up to swap-removals)
+    vector<int> cluster_starts;
+    int id_next = 1;
+    int next_seq_key = 0;
+    long ops_generated = 0;
+    int hot_start = 0;
+
+    int gen_key() {
+        switch (spec.key_dist) {
+            case KEYDIST_ZIPF: {
+                const uint64_t rank = zipf.sample(KEY_MAX + 1) - 1;
+                return (int)((rank * ZIPF_SCRAMBLE) % (KEY_MAX + 1));
+            }
+            case KEYDIST_SEQUENTIAL: {
+                const int key = next_seq_key;
+                next_seq_key = (next_seq_key == KEY_MAX) ? 0 : next_seq_key + 1;
+                return key;
+            }
+            case KEYDIST_CLUSTERED: {
+                const int start = cluster_starts[rng.rand_range(0, spec.num_clusters - 1)];
+                return min(start + rng.rand_range(0, spec.cluster_width - 1), KEY_MAX);
+            }
+            default:  // KEYDIST_UNIFORM, KEYDIST_HOTSPOT
+                return rng.rand_key();
+        }
+    }
+
+    // Index into `records` of the record an access should target. Requires records to be non-empty
+    int pick_record() {
+        const int n = (int)records.size();
+        switch (spec.key_dist) {
+            case KEYDIST_ZIPF:
+                return zipf.sample(n) - 1;  // earliest records are hottest
+            case KEYDIST_SEQUENTIAL:
+                return n - zipf.sample(n);  // latest records are hottest
+            case KEYDIST_HOTSPOT:
+                if (rng.rand_unit() < spec.hot_fraction) {
+                    return (hot_start + rng.rand_range(0, spec.hot_width - 1)) % n;
+                }
+                return rng.rand_range(0, n - 1);
+            default:  // KEYDIST_UNIFORM, KEYDIST_CLUSTERED
+                return rng.rand_range(0, n - 1);
+        }
+    }
+
+    packed_op insertion(const int key) {
+        records.push_back(key);
+        packed_op op = {OPTYPE_INSERTION, {id_next++, key}};
+        return op;
+    }
+
+    // Remove records[i] from the pool (swap with last) and return its key
+    int take_record(const int i) {
+        const int key = records[i];
+        records[i] = records.back();
+        records.pop_back();
+        return key;
+    }
+
+   public:
+    explicit WorkloadGenerator(const workload_spec& spec) : spec(spec), zipf(spec.zipf_theta) {
+        for (int i = 0; i < spec.num_clusters; i++) {
+            cluster_starts.push_back(rng.rand_range(0, KEY_MAX));
+        }
+    }
+
+    // Load phase: num_records insertions
+    vector<packed_op> gen_load(const int num_records) {
+        vector<packed_op> ops;
+        ops.reserve(num_records);
+        for (int i = 0; i < num_records; i++) {
+            ops.push_back(insertion(gen_key()));
+        }
+        return ops;
+    }
+
+    // Run phase: num_operations logical operations drawn from the mix. Updates expand into a
+    // deletion and an insertion, so the result can be longer than num_operations.
+    vector<packed_op> gen_run(const int num_operations) {
+        const workload_mix& mix = spec.mix;
+        vector<packed_op> ops;
+        ops.reserve(num_operations + (long)num_operations * mix.update_pct / 100);
+
+        for (int i = 0; i < num_operations; i++, ops_generated++) {
+            if (spec.hot_move_every > 0 && ops_generated % spec.hot_move_every == 0 && i > 0) {
+                hot_start += spec.hot_width;
+            }
+            if (!records.empty()) {
+                hot_start %= records.size();
+            }
+
+            // With nothing to access yet, every operation is an insertion to seed the pool
+            int r = rng.rand_range(0, 99);
+            if (r < mix.insert_pct || records.empty()) {
+                ops.push_back(insertion(gen_key()));
+                continue;
+            }
+            r -= mix.insert_pct;
+            if (r < mix.delete_pct) {
+                packed_op op = {OPTYPE_DELETION, {0, take_record(pick_record())}};
+                ops.push_back(op);
+                continue;
+            }
+            r -= mix.delete_pct;
+            if (r < mix.search_pct) {
+                packed_op op = {OPTYPE_SEARCH, {0, records[pick_record()]}};
+                ops.push_back(op);
+                continue;
+            }
+            r -= mix.search_pct;
+            if (r < mix.range_pct) {
+                packed_op op = {OPTYPE_RANGE,
+                                {rng.rand_range(0, spec.max_scan_span - 1), records[pick_record()]}};
+                ops.push_back(op);
+                continue;
+            }
+            // update: replace a record with a new version
+            const int key = take_record(pick_record());
+            packed_op del = {OPTYPE_DELETION, {0, key}};
+            ops.push_back(del);
+            ops.push_back(insertion(key));
+        }
+        return ops;
+    }
+};
+
+#endif  // WORKLOAD_GENERATOR_H